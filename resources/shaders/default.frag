@@ -2,6 +2,7 @@
 out vec4 FragColor;
 
 in vec3 TexCoord;
+in float Light;
 
 // texture samplers
 //uniform sampler2D texture0;
@@ -9,5 +10,6 @@ uniform sampler2DArray texture0;
 
 void main()
 {
-	FragColor = texture(texture0, TexCoord);
+	vec4 color = texture(texture0, TexCoord);
+	FragColor = vec4(color.rgb * Light, color.a);
 }
\ No newline at end of file
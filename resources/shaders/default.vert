@@ -1,8 +1,10 @@
 #version 330 core
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aTexCoord;
+layout (location = 2) in float aLight;
 
 out vec3 TexCoord;
+out float Light;
 
 uniform mat4 MVP;
 
@@ -10,4 +12,5 @@ void main()
 {
 	gl_Position = MVP * vec4(aPos, 1.0f);
 	TexCoord = vec3(aTexCoord.x, aTexCoord.y, aTexCoord.z);
+	Light = aLight;
 }
\ No newline at end of file
@@ -0,0 +1,17 @@
+#version 330 core
+out vec4 FragColor;
+
+in vec3 TexCoord;
+in float Light;
+
+uniform sampler2DArray texture0;
+
+void main()
+{
+	vec4 color = texture(texture0, TexCoord);
+	if (color.a < 0.5f)
+	{
+		discard;
+	}
+	FragColor = vec4(color.rgb * Light, color.a);
+}
\ No newline at end of file
@@ -0,0 +1,20 @@
+#version 330 core
+layout (location = 0) in vec2 aCorner;
+layout (location = 1) in vec4 aPositionSize;
+layout (location = 2) in vec2 aTextureLight;
+
+out vec3 TexCoord;
+out float Light;
+
+uniform mat4 VP;
+uniform vec3 CameraRight;
+uniform vec3 CameraUp;
+
+void main()
+{
+	vec3 position = aPositionSize.xyz + (CameraRight * aCorner.x + CameraUp * aCorner.y) * aPositionSize.w;
+	gl_Position = VP * vec4(position, 1.0f);
+	TexCoord = vec3(aCorner + 0.5f, aTextureLight.x);
+	// Same falloff as the map vertices
+	Light = 0.05f + 0.95f * pow(0.8f, 15.0f - aTextureLight.y);
+}
\ No newline at end of file
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <chrono>
+
+
+namespace bench
+{
+  template <typename Function>
+  double MeasureSeconds(Function function)
+  {
+    auto startTime = std::chrono::steady_clock::now();
+    function();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+  }
+}
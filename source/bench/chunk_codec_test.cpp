@@ -0,0 +1,181 @@
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "scene/chunk_codec.hpp"
+#include "bench_utils.hpp"
+
+
+namespace
+{
+  enum class ChunkShape
+  {
+    // Columns of a few blocks over air, like generated terrain
+    Terrain,
+    // Runs of random length over a random palette
+    Runs,
+    // Every block picked from the palette on its own, the worst case for run lengths
+    Noise
+  };
+
+  void FillChunk(blocks::Chunk& chunk, ChunkShape shape, std::mt19937& random)
+  {
+    std::uniform_int_distribution<int> paletteSize(1, shape == ChunkShape::Terrain ? 5 : 4096);
+    std::vector<blocks::Block> palette(paletteSize(random));
+    for (blocks::Block& block : palette)
+    {
+      block = (blocks::Block)random();
+    }
+    std::uniform_int_distribution<size_t> paletteIndex(0, palette.size() - 1);
+
+    if (shape == ChunkShape::Terrain)
+    {
+      std::uniform_int_distribution<int> height(0, (int)blocks::Chunk::Height);
+      for (size_t column = 0; column < blocks::Chunk::LayerBlocksNumber; column++)
+      {
+        int columnHeight = height(random);
+        for (int z = 0; z < (int)blocks::Chunk::Height; z++)
+        {
+          chunk.blocks[column + z * blocks::Chunk::LayerBlocksNumber] = z < columnHeight ? palette[std::min<size_t>(z / 64, palette.size() - 1)] : 0;
+        }
+      }
+      return;
+    }
+
+    std::geometric_distribution<size_t> runLength(1.0 / std::uniform_int_distribution<int>(1, 4096)(random));
+    for (size_t i = 0; i < blocks::Chunk::BlocksNumber; )
+    {
+      size_t length = shape == ChunkShape::Noise ? 1 : std::min(runLength(random) + 1, blocks::Chunk::BlocksNumber - i);
+      std::fill(chunk.blocks + i, chunk.blocks + i + length, palette[paletteIndex(random)]);
+      i += length;
+    }
+  }
+
+  std::vector<blocks::ScheduledTick> MakeTicks(std::mt19937& random)
+  {
+    std::set<std::uint32_t> indices;
+    std::uniform_int_distribution<int> ticksNumber(0, 300);
+    std::uniform_int_distribution<std::uint32_t> index(0, blocks::Chunk::BlocksNumber - 1);
+    for (int i = ticksNumber(random); i > 0; i--)
+    {
+      indices.insert(index(random));
+    }
+
+    std::vector<blocks::ScheduledTick> ticks;
+    for (std::uint32_t tickIndex : indices)
+    {
+      ticks.push_back(blocks::ScheduledTick{ tickIndex, (std::uint32_t)random() });
+    }
+    std::shuffle(ticks.begin(), ticks.end(), random);
+
+    return ticks;
+  }
+
+  bool AreTicksEqual(std::vector<blocks::ScheduledTick> ticks1, const std::vector<blocks::ScheduledTick>& ticks2)
+  {
+    std::sort(ticks1.begin(), ticks1.end(), [](const blocks::ScheduledTick& tick1, const blocks::ScheduledTick& tick2) { return tick1.index < tick2.index; });
+    return ticks1.size() == ticks2.size() && std::equal(ticks1.begin(), ticks1.end(), ticks2.begin(),
+      [](const blocks::ScheduledTick& tick1, const blocks::ScheduledTick& tick2) { return tick1.index == tick2.index && tick1.delay == tick2.delay; });
+  }
+}
+
+
+// Round trips random chunks through ChunkCodec, feeds truncated and corrupted data to Decode
+// and measures encoding and decoding speed. Returns a non zero code when any check fails.
+int main(int argc, char** argv)
+{
+  const int ChunksNumber = 300;
+  const int CorruptionsNumber = 20;
+
+  std::mt19937 random(11);
+  std::unique_ptr<blocks::Chunk> chunk = std::make_unique<blocks::Chunk>();
+  std::unique_ptr<blocks::Chunk> decoded = std::make_unique<blocks::Chunk>();
+  std::vector<blocks::ScheduledTick> decodedTicks;
+  size_t failuresNumber = 0;
+  size_t decodesNumber = 0;
+
+  for (int i = 0; i < ChunksNumber; i++)
+  {
+    ChunkShape shape = (ChunkShape)(i % 3);
+    FillChunk(*chunk, shape, random);
+    std::vector<blocks::ScheduledTick> ticks = i % 2 == 0 ? MakeTicks(random) : std::vector<blocks::ScheduledTick>();
+    std::vector<unsigned char> data = blocks::ChunkCodec::Encode(*chunk, ticks);
+
+    if (!blocks::ChunkCodec::Decode(data.data(), data.size(), *decoded, &decodedTicks) ||
+      !blocks::Chunk::AreEqual(*chunk, *decoded) || !AreTicksEqual(ticks, decodedTicks))
+    {
+      std::cout << std::format("Round trip failed: chunk {}, {} bytes, {} ticks\n", i, data.size(), ticks.size());
+      failuresNumber++;
+    }
+
+    // Every strict prefix misses part of the runs or the ticks
+    std::uniform_int_distribution<size_t> prefix(0, data.size() - 1);
+    for (int j = 0; j < 64; j++)
+    {
+      size_t size = j < 32 ? std::min<size_t>(j, data.size() - 1) : prefix(random);
+      if (blocks::ChunkCodec::Decode(data.data(), size, *decoded, &decodedTicks))
+      {
+        std::cout << std::format("Truncated data decoded: chunk {}, {} of {} bytes\n", i, size, data.size());
+        failuresNumber++;
+      }
+      decodesNumber++;
+    }
+
+    // Corrupted data may still decode, it just must not read or write out of bounds
+    std::uniform_int_distribution<size_t> position(0, data.size() - 1);
+    for (int j = 0; j < CorruptionsNumber; j++)
+    {
+      std::vector<unsigned char> corrupted = data;
+      for (int k = 0; k <= j % 4; k++)
+      {
+        corrupted[position(random)] ^= (unsigned char)(1 + random() % 255);
+      }
+      if (blocks::ChunkCodec::Decode(corrupted.data(), corrupted.size(), *decoded, &decodedTicks))
+      {
+        for (const blocks::ScheduledTick& tick : decodedTicks)
+        {
+          if (tick.index >= blocks::Chunk::BlocksNumber)
+          {
+            std::cout << std::format("Corrupted data decoded a tick out of the chunk: chunk {}\n", i);
+            failuresNumber++;
+          }
+        }
+      }
+      decodesNumber++;
+    }
+  }
+
+  std::cout << std::format("Round tripped {} chunks, {} truncated and corrupted decodes, {} failures\n", ChunksNumber, decodesNumber, failuresNumber);
+
+  // Throughput in uncompressed chunk bytes
+  const int Repeats = 200;
+  for (ChunkShape shape : { ChunkShape::Terrain, ChunkShape::Noise })
+  {
+    FillChunk(*chunk, shape, random);
+    std::vector<unsigned char> data;
+    double encodeTime = bench::MeasureSeconds([&]()
+      {
+        for (int i = 0; i < Repeats; i++)
+        {
+          data = blocks::ChunkCodec::Encode(*chunk);
+        }
+      });
+    double decodeTime = bench::MeasureSeconds([&]()
+      {
+        for (int i = 0; i < Repeats; i++)
+        {
+          blocks::ChunkCodec::Decode(data.data(), data.size(), *decoded);
+        }
+      });
+
+    double megabytes = (double)Repeats * sizeof(blocks::Chunk) / (1024.0 * 1024.0);
+    std::cout << std::format("{}: {} bytes encoded, encode {:.1f} MB/s, decode {:.1f} MB/s\n",
+      shape == ChunkShape::Terrain ? "Terrain" : "Noise", data.size(), megabytes / encodeTime, megabytes / decodeTime);
+  }
+
+  return failuresNumber == 0 ? 0 : 1;
+}
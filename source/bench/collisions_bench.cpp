@@ -0,0 +1,131 @@
+#include <cfloat>
+#include <format>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "geometry/collisions_api.hpp"
+#include "bench_utils.hpp"
+
+
+namespace
+{
+  // Grid aligned rays and boxes hit the degenerate cases, rays lying in box planes and touching faces
+  blocks::Ray RandomRay(std::mt19937& random, bool isAligned)
+  {
+    std::uniform_int_distribution<int> cell(-4, 4);
+    std::uniform_int_distribution<int> step(-1, 1);
+    std::uniform_real_distribution<float> value(-4.0f, 4.0f);
+    if (isAligned)
+    {
+      return blocks::Ray(glm::vec3(cell(random), cell(random), cell(random)) * 0.5f, glm::vec3(step(random), step(random), step(random)));
+    }
+    return blocks::Ray(glm::vec3(value(random), value(random), value(random)), glm::vec3(value(random), value(random), value(random)));
+  }
+
+  blocks::AABB RandomBox(std::mt19937& random, bool isAligned)
+  {
+    std::uniform_int_distribution<int> cell(-4, 4);
+    std::uniform_int_distribution<int> size(0, 2);
+    std::uniform_real_distribution<float> value(-4.0f, 4.0f);
+    glm::vec3 low = isAligned ? glm::vec3(cell(random), cell(random), cell(random)) : glm::vec3(value(random), value(random), value(random));
+    glm::vec3 extent = isAligned ? glm::vec3(size(random), size(random), size(random)) : glm::vec3(value(random), value(random), value(random)) * 0.25f + 1.0f;
+    return blocks::AABB(low, low + extent);
+  }
+}
+
+
+// Compares the batched SIMD collision tests with the single pair ones and measures both.
+// Returns a non zero code when any result differs.
+int main(int argc, char** argv)
+{
+  const size_t BoxesNumber = 1027;
+  const int RaysNumber = 200;
+
+  std::mt19937 random(7);
+  size_t mismatchesNumber = 0;
+  size_t pairsNumber = 0;
+
+  blocks::AABBBatch boxes;
+  std::vector<blocks::AABB> boxList;
+  std::vector<float> distances(BoxesNumber);
+  std::vector<char> results(BoxesNumber);
+  for (int pass = 0; pass < 2; pass++)
+  {
+    bool isAligned = pass == 0;
+
+    boxes.Clear();
+    boxList.clear();
+    for (size_t i = 0; i < BoxesNumber; i++)
+    {
+      boxList.push_back(RandomBox(random, isAligned));
+      boxes.Add(boxList.back());
+    }
+
+    for (int r = 0; r < RaysNumber; r++)
+    {
+      blocks::Ray ray = RandomRay(random, isAligned);
+      blocks::CheckCollisions(ray, boxes, distances.data());
+
+      blocks::AABB bounds = RandomBox(random, isAligned);
+      size_t hitsNumber = blocks::CheckCollisions(bounds, boxes, (bool*)results.data());
+
+      size_t expectedHitsNumber = 0;
+      for (size_t i = 0; i < BoxesNumber; i++)
+      {
+        float expected = blocks::CheckCollision(ray, boxList[i]).distance;
+        bool isExpectedHit = blocks::CheckCollision(bounds, boxList[i]);
+        expectedHitsNumber += isExpectedHit;
+        if (distances[i] != expected || (bool)results[i] != isExpectedHit)
+        {
+          if (mismatchesNumber < 8)
+          {
+            std::cout << std::format("Mismatch: ray ({}, {}, {}) dir ({}, {}, {}) box {}: batch {} single {}\n",
+              ray.origin.x, ray.origin.y, ray.origin.z, ray.direction.x, ray.direction.y, ray.direction.z, i, distances[i], expected);
+          }
+          mismatchesNumber++;
+        }
+      }
+      mismatchesNumber += hitsNumber != expectedHitsNumber;
+      pairsNumber += BoxesNumber;
+    }
+  }
+
+  std::cout << std::format("Checked {} ray and box pairs, {} mismatches\n", pairsNumber, mismatchesNumber);
+
+  // Throughput over random boxes, the checksums keep the loops from being optimized away
+  const int Repeats = 2000;
+  float singleChecksum = 0.0f;
+  double singleTime = bench::MeasureSeconds([&]()
+    {
+      for (int r = 0; r < Repeats; r++)
+      {
+        blocks::Ray ray = blocks::Ray(glm::vec3(0.1f * r, 0.5f, 0.5f), glm::vec3(0.3f, 1.0f, 0.2f));
+        for (size_t i = 0; i < BoxesNumber; i++)
+        {
+          float distance = blocks::CheckCollision(ray, boxList[i]).distance;
+          singleChecksum += distance != FLT_MAX ? distance : 0.0f;
+        }
+      }
+    });
+
+  float batchChecksum = 0.0f;
+  double batchTime = bench::MeasureSeconds([&]()
+    {
+      for (int r = 0; r < Repeats; r++)
+      {
+        blocks::Ray ray = blocks::Ray(glm::vec3(0.1f * r, 0.5f, 0.5f), glm::vec3(0.3f, 1.0f, 0.2f));
+        blocks::CheckCollisions(ray, boxes, distances.data());
+        for (size_t i = 0; i < BoxesNumber; i++)
+        {
+          batchChecksum += distances[i] != FLT_MAX ? distances[i] : 0.0f;
+        }
+      }
+    });
+
+  double testsNumber = (double)Repeats * BoxesNumber;
+  std::cout << std::format("Ray and box, single: {:.1f} M tests/s, batch: {:.1f} M tests/s, checksums {} {}\n",
+    testsNumber / singleTime * 1e-6, testsNumber / batchTime * 1e-6, singleChecksum, batchChecksum);
+
+  return mismatchesNumber == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "scene/entity_world.hpp"
+#include "scene/map.hpp"
+#include "math_utils.hpp"
+
+
+namespace
+{
+  // Highest free cell of the column, entities start standing on the terrain
+  float FindSurface(blocks::Map& map, int x, int y)
+  {
+    std::pair<int, int> chunkPosition = std::make_pair(blocks::floorDivide(x, blocks::Chunk::Length), blocks::floorDivide(y, blocks::Chunk::Width));
+    std::shared_ptr<const blocks::Chunk> chunk = map.GetChunk(chunkPosition);
+    int localX = x - chunkPosition.first * (int)blocks::Chunk::Length;
+    int localY = y - chunkPosition.second * (int)blocks::Chunk::Width;
+    for (int z = (int)blocks::Chunk::Height - 1; z >= 0; z--)
+    {
+      if (chunk->blocks[localX + localY * blocks::Chunk::Width + z * blocks::Chunk::LayerBlocksNumber] != 0)
+      {
+        return (float)(z + 1);
+      }
+    }
+    return 0.0f;
+  }
+}
+
+
+// Times EntityWorld::Update for a swarm walking over generated terrain.
+// Usage: BlocksEntityBench [entities number] [ticks number]
+int main(int argc, char** argv)
+{
+  const float TickDelta = 1.0f / 60.0f;
+  const int ChunksRadius = 4;
+  const float SwarmRadius = 56.0f;
+
+  size_t entitiesNumber = argc > 1 ? std::stoul(argv[1]) : 10000;
+  int ticksNumber = argc > 2 ? std::stoi(argv[2]) : 600;
+
+  blocks::Map map(1);
+  for (int x = -ChunksRadius; x <= ChunksRadius; x++)
+  {
+    for (int y = -ChunksRadius; y <= ChunksRadius; y++)
+    {
+      map.GetChunk(std::make_pair(x, y));
+    }
+  }
+
+  std::mt19937 random(3);
+  std::uniform_real_distribution<float> offset(-SwarmRadius, SwarmRadius);
+  std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+  blocks::EntityWorld entities;
+  for (size_t i = 0; i < entitiesNumber; i++)
+  {
+    glm::vec3 position = glm::vec3(offset(random), offset(random), 0.0f);
+    position.z = FindSurface(map, (int)std::floor(position.x), (int)std::floor(position.y)) + 0.5f;
+    entities.Spawn(blocks::EntityType::Mob, position, glm::vec3(speed(random), speed(random), 0.0f));
+  }
+
+  std::vector<double> tickTimes;
+  tickTimes.reserve(ticksNumber);
+  for (int tick = 0; tick < ticksNumber; tick++)
+  {
+    auto startTime = std::chrono::steady_clock::now();
+    entities.Update(TickDelta, map);
+    tickTimes.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+  }
+
+  double meanTime = 0.0;
+  for (double time : tickTimes)
+  {
+    meanTime += time;
+  }
+  meanTime /= std::max(ticksNumber, 1);
+  std::sort(tickTimes.begin(), tickTimes.end());
+  double p99Time = tickTimes.empty() ? 0.0 : tickTimes[std::min(tickTimes.size() - 1, tickTimes.size() * 99 / 100)];
+  double maxTime = tickTimes.empty() ? 0.0 : tickTimes.back();
+
+  double budget = TickDelta * 1000.0;
+  std::cout << std::format("{} entities, {} ticks: mean {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms per tick, budget {:.2f} ms\n",
+    entities.GetEntitiesNumber(), ticksNumber, meanTime, p99Time, maxTime, budget);
+
+  // Fails when the swarm does not fit a 60 Hz simulation tick on average
+  return meanTime <= budget ? 0 : 1;
+}
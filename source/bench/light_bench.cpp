@@ -0,0 +1,165 @@
+#include <algorithm>
+#include <format>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "scene/light_engine.hpp"
+#include "scene/map.hpp"
+#include "math_utils.hpp"
+#include "bench_utils.hpp"
+
+
+namespace
+{
+  const int ChunksRadius = 3;
+  // Generated terrain uses blocks 1 to 4, the light source placed by the edits comes after them
+  const blocks::Block LampBlock = 5;
+
+  struct LitWorld
+  {
+    std::map<std::pair<int, int>, std::shared_ptr<blocks::Chunk>> chunks;
+    std::map<std::pair<int, int>, std::shared_ptr<const blocks::ChunkLight>> lights;
+
+    blocks::LightEngine::ChunkSource GetSource()
+    {
+      return [this](std::pair<int, int> position, std::shared_ptr<const blocks::Chunk>& chunk, std::shared_ptr<const blocks::ChunkLight>& light)
+      {
+        auto it = lights.find(position);
+        if (it == lights.end())
+        {
+          return false;
+        }
+        chunk = chunks[position];
+        light = it->second;
+        return true;
+      };
+    }
+
+    void Publish(blocks::LightEngine& engine)
+    {
+      for (const auto& [position, light] : engine.TakeChangedLights())
+      {
+        lights[position] = light;
+      }
+    }
+  };
+}
+
+
+// Measures chunk lighting and light repairs after single block edits on generated terrain.
+// Usage: BlocksLightBench [edits number]
+int main(int argc, char** argv)
+{
+  int editsNumber = argc > 1 ? std::stoi(argv[1]) : 2000;
+
+  std::vector<blocks::BlockInfo> infos(LampBlock);
+  infos[LampBlock - 1].lightEmission = 15;
+  blocks::BlockRegistry registry(infos);
+
+  LitWorld world;
+  blocks::Map map(1);
+  for (int x = -ChunksRadius; x <= ChunksRadius; x++)
+  {
+    for (int y = -ChunksRadius; y <= ChunksRadius; y++)
+    {
+      world.chunks[std::make_pair(x, y)] = std::make_shared<blocks::Chunk>(*map.GetChunk(std::make_pair(x, y)));
+    }
+  }
+
+  // Chunks on their own
+  const int ComputeRepeats = 4;
+  std::map<std::pair<int, int>, std::shared_ptr<blocks::ChunkLight>> computedLights;
+  double computeTime = bench::MeasureSeconds([&]()
+    {
+      for (int repeat = 0; repeat < ComputeRepeats; repeat++)
+      {
+        for (const auto& [position, chunk] : world.chunks)
+        {
+          computedLights[position] = blocks::LightEngine::ComputeChunk(*chunk, &registry);
+        }
+      }
+    });
+
+  // Light exchange with the neighbours lit before
+  double attachTime = bench::MeasureSeconds([&]()
+    {
+      for (const auto& [position, chunk] : world.chunks)
+      {
+        blocks::LightEngine engine(&registry, world.GetSource());
+        engine.AttachChunk(position, chunk, computedLights[position]);
+        world.Publish(engine);
+      }
+    });
+
+  // Lamps placed on the surface and removed again, every edit is repaired by its own engine as Map does
+  std::mt19937 random(5);
+  int innerSize = (2 * ChunksRadius - 1) * (int)blocks::Chunk::Length;
+  std::uniform_int_distribution<int> coordinate(-innerSize / 2, innerSize / 2 - 1);
+  std::vector<glm::ivec3> lamps;
+  int updatesNumber = 0;
+  size_t changedLightsNumber = 0;
+  double editTime = 0.0;
+  for (int edit = 0; edit < editsNumber; edit++)
+  {
+    glm::ivec3 cell;
+    blocks::Block block;
+    if (lamps.size() < 64 || edit % 2 == 1)
+    {
+      cell = glm::ivec3(coordinate(random), coordinate(random), (int)blocks::Chunk::Height - 1);
+      block = LampBlock;
+    }
+    else
+    {
+      std::uniform_int_distribution<size_t> lampIndex(0, lamps.size() - 1);
+      size_t index = lampIndex(random);
+      cell = lamps[index];
+      lamps[index] = lamps.back();
+      lamps.pop_back();
+      block = 0;
+    }
+
+    std::pair<int, int> chunkPosition = std::make_pair(blocks::floorDivide(cell.x, blocks::Chunk::Length), blocks::floorDivide(cell.y, blocks::Chunk::Width));
+    blocks::Chunk& chunk = *world.chunks[chunkPosition];
+    int localX = cell.x - chunkPosition.first * (int)blocks::Chunk::Length;
+    int localY = cell.y - chunkPosition.second * (int)blocks::Chunk::Width;
+    if (block == LampBlock)
+    {
+      // Lamp goes on top of the column
+      while (cell.z > 0 && chunk.blocks[localX + localY * blocks::Chunk::Width + (cell.z - 1) * blocks::Chunk::LayerBlocksNumber] == 0)
+      {
+        cell.z--;
+      }
+      if (chunk.blocks[localX + localY * blocks::Chunk::Width + cell.z * blocks::Chunk::LayerBlocksNumber] != 0)
+      {
+        continue;
+      }
+      lamps.push_back(cell);
+    }
+    chunk.blocks[localX + localY * blocks::Chunk::Width + cell.z * blocks::Chunk::LayerBlocksNumber] = block;
+
+    editTime += bench::MeasureSeconds([&]()
+      {
+        blocks::LightEngine engine(&registry, world.GetSource());
+        engine.UpdateBlock(cell);
+        std::vector<std::pair<std::pair<int, int>, std::shared_ptr<blocks::ChunkLight>>> changedLights = engine.TakeChangedLights();
+        changedLightsNumber += changedLights.size();
+        updatesNumber++;
+        for (const auto& [position, light] : changedLights)
+        {
+          world.lights[position] = light;
+        }
+      });
+  }
+
+  size_t chunksNumber = world.chunks.size();
+  std::cout << std::format("ComputeChunk: {:.1f} chunks/s\n", chunksNumber * ComputeRepeats / computeTime);
+  std::cout << std::format("AttachChunk: {:.1f} chunks/s\n", chunksNumber / attachTime);
+  std::cout << std::format("UpdateBlock: {:.1f} updates/s over {} edits, {:.3f} ms per update, {:.2f} lights copied per update\n",
+    updatesNumber / editTime, updatesNumber, editTime * 1000.0 / std::max(updatesNumber, 1), (double)changedLightsNumber / std::max(updatesNumber, 1));
+
+  return 0;
+}
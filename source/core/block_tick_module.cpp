@@ -0,0 +1,46 @@
+#include "block_tick_module.hpp"
+
+#include <set>
+
+#include "math_utils.hpp"
+
+
+namespace blocks
+{
+  BlockTickModule::BlockTickModule()
+  {
+
+  }
+
+  BlockTickModule::~BlockTickModule()
+  {
+
+  }
+
+
+  void BlockTickModule::Update(float delta, GameContext& context)
+  {
+    if (!context.scene->ContainsMap())
+    {
+      return;
+    }
+
+    std::shared_ptr<Map> map = context.scene->GetMap();
+    std::vector<glm::ivec3> changedCells = map->GetBlockTicks()->Update(*map);
+
+    // Neighbouring systems see the changes like player edits
+    std::set<std::pair<int, int>> changedChunks;
+    for (const glm::ivec3& cell : changedCells)
+    {
+      context.scene->GetFluids()->Activate(cell);
+      context.scene->GetPaths()->InvalidateCell(cell);
+      changedChunks.insert(std::make_pair(floorDivide(cell.x, Chunk::Length), floorDivide(cell.y, Chunk::Width)));
+    }
+
+    // Meshed on the render update thread like fluid changes
+    for (const std::pair<int, int>& position : changedChunks)
+    {
+      context.openglScene->GetMap()->EnqueueChunkRemesh(position);
+    }
+  }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "game_module_interface.hpp"
+
+
+namespace blocks
+{
+  // Runs the block updates due on each simulation tick and remeshes the chunks they changed
+  class BlockTickModule : public GameModuleInterface
+  {
+  public:
+    BlockTickModule();
+    BlockTickModule(const BlockTickModule&) = delete;
+    BlockTickModule(BlockTickModule&& other) = delete;
+    BlockTickModule& operator=(const BlockTickModule&) = delete;
+    BlockTickModule& operator=(BlockTickModule&& other) = delete;
+    ~BlockTickModule() override;
+
+    virtual void Update(float delta, GameContext& context) override;
+  };
+}
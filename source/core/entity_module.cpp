@@ -0,0 +1,38 @@
+#include "entity_module.hpp"
+
+
+namespace blocks
+{
+  EntityModule::EntityModule()
+  {
+
+  }
+
+  EntityModule::~EntityModule()
+  {
+
+  }
+
+
+  void EntityModule::Update(float delta, GameContext& context)
+  {
+    if (context.scene->ContainsMap())
+    {
+      context.scene->GetEntities()->Update(delta, *context.scene->GetMap());
+    }
+  }
+
+  void EntityModule::SpawnSwarm(GameContext& context, size_t entitiesNumber)
+  {
+    std::shared_ptr<EntityWorld> entities = context.scene->GetEntities();
+    glm::vec3 center = context.camera->GetPosition();
+
+    std::uniform_real_distribution<float> offset(-swarmRadius_, swarmRadius_);
+    std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+    for (size_t i = 0; i < entitiesNumber; i++)
+    {
+      glm::vec3 position = center + glm::vec3(offset(random_), offset(random_), 0.0f);
+      entities->Spawn(EntityType::Mob, position, glm::vec3(speed(random_), speed(random_), 0.0f));
+    }
+  }
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <random>
+
+#include "game_module_interface.hpp"
+
+
+namespace blocks
+{
+  // Steps the scene entities once per simulation tick
+  class EntityModule : public GameModuleInterface
+  {
+  public:
+    EntityModule();
+    EntityModule(const EntityModule&) = delete;
+    EntityModule(EntityModule&& other) = delete;
+    EntityModule& operator=(const EntityModule&) = delete;
+    EntityModule& operator=(EntityModule&& other) = delete;
+    ~EntityModule() override;
+
+    virtual void Update(float delta, GameContext& context) override;
+
+    // Drops mobs around the camera, used to stress the simulation
+    void SpawnSwarm(GameContext& context, size_t entitiesNumber);
+
+  private:
+    float swarmRadius_ = 24.0f;
+    std::mt19937 random_;
+  };
+}
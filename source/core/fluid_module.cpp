@@ -0,0 +1,31 @@
+#include "fluid_module.hpp"
+
+
+namespace blocks
+{
+  FluidModule::FluidModule()
+  {
+
+  }
+
+  FluidModule::~FluidModule()
+  {
+
+  }
+
+
+  void FluidModule::Update(float delta, GameContext& context)
+  {
+    if (context.scene->ContainsMap())
+    {
+      std::shared_ptr<Map> map = context.scene->GetMap();
+      std::vector<std::pair<int, int>> changedChunks = context.scene->GetFluids()->Update(*map);
+
+      // Meshed on the render update thread, once for all the steps until then
+      for (const std::pair<int, int>& position : changedChunks)
+      {
+        context.openglScene->GetMap()->EnqueueChunkRemesh(position);
+      }
+    }
+  }
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "game_module_interface.hpp"
+
+
+namespace blocks
+{
+  // Steps the scene fluids once per simulation tick and remeshes every chunk they changed
+  class FluidModule : public GameModuleInterface
+  {
+  public:
+    FluidModule();
+    FluidModule(const FluidModule&) = delete;
+    FluidModule(FluidModule&& other) = delete;
+    FluidModule& operator=(const FluidModule&) = delete;
+    FluidModule& operator=(FluidModule&& other) = delete;
+    ~FluidModule() override;
+
+    virtual void Update(float delta, GameContext& context) override;
+  };
+}
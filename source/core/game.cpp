@@ -94,6 +94,12 @@ namespace blocks
 
         playerControlModule_.Update(deltaF, inputState, context_);
         mapLoadingModule_.Update(deltaF, context_);
+        mapSavingModule_.Update(deltaF, context_);
+        entityModule_.Update(deltaF, context_);
+        fluidModule_.Update(deltaF, context_);
+        pathfindingModule_.Update(deltaF, context_);
+        particleModule_.Update(deltaF, context_);
+        blockTickModule_.Update(deltaF, context_);
       }
 
       mut.lock();
@@ -208,6 +214,25 @@ namespace blocks
     );
     window->AddElement(createWorldButton);
 
+    std::shared_ptr<ImguiButton> createMappedWorldButton = std::make_shared<ImguiButton>(
+      "Create new mapped world",
+      [this]()
+      {
+        // Mapped world is written to disk as it is generated, so it replaces the saved world right away
+        blocks::removeDirectory("map");
+        blocks::createDirectory("map");
+
+        srand(time(0));
+        std::shared_ptr<Map> map = std::make_shared<Map>(rand());
+        blocks::saveTextFile("map/seed.txt", std::to_string(map->GetSeed()));
+        map->SetMappedStore(std::make_shared<MappedWorldStore>("map/mapped"));
+
+        std::shared_ptr<Scene> worldScene_ = CreateWorldScene(map);
+        RequestScene(worldScene_);
+      }
+    );
+    window->AddElement(createMappedWorldButton);
+
     std::shared_ptr<ImguiButton> loadWorldButton = std::make_shared<ImguiButton>(
       "Load world",
       [this]()
@@ -232,6 +257,15 @@ namespace blocks
   {
     std::shared_ptr<Scene> scene = std::make_shared<Scene>();
 
+    // Without a block set every non-air block is solid and nothing ticks, flows or glows
+    ResourceBase& resourceBase = Environment::GetResource();
+    std::shared_ptr<std::vector<std::string>> blockSetNames = resourceBase.GetBlockSetNames();
+    std::shared_ptr<BlockSet> blockSet = blockSetNames->empty() ? nullptr : resourceBase.LoadBlockSet(blockSetNames->front());
+    if (blockSet)
+    {
+      map->SetBlockRegistry(blockSet->GetRegistry());
+    }
+
     scene->SetMap(map);
 
     std::shared_ptr<ImguiWindow> window = std::make_shared<ImguiWindow>("Statistics");
@@ -271,23 +305,95 @@ namespace blocks
     );
     window->AddElement(seedText);
 
+    std::shared_ptr<ImguiText> saveText = std::make_shared<ImguiText>(
+      [this]()
+      {
+        return std::format("Unsaved chunks: {}{}", context_.scene->GetMap()->GetDirtyChunksNumber(), mapSavingModule_.IsSaving() ? " (saving)" : "");
+      }
+    );
+    window->AddElement(saveText);
+
+    std::shared_ptr<ImguiText> residentText = std::make_shared<ImguiText>(
+      [this]()
+      {
+        return std::format("Resident chunks: {}", context_.scene->GetMap()->GetResidentChunksNumber());
+      }
+    );
+    window->AddElement(residentText);
+
+    std::shared_ptr<ImguiText> entitiesText = std::make_shared<ImguiText>(
+      [this]()
+      {
+        return std::format("Entities: {}", context_.scene->GetEntities()->GetEntitiesNumber());
+      }
+    );
+    window->AddElement(entitiesText);
+
+    std::shared_ptr<ImguiText> fluidsText = std::make_shared<ImguiText>(
+      [this]()
+      {
+        return std::format("Active fluid cells: {}", context_.scene->GetFluids()->GetActiveCellsNumber());
+      }
+    );
+    window->AddElement(fluidsText);
+
+    std::shared_ptr<ImguiText> particlesText = std::make_shared<ImguiText>(
+      [this]()
+      {
+        return std::format("Particles: {}", context_.scene->GetParticles()->GetParticlesNumber());
+      }
+    );
+    window->AddElement(particlesText);
+
+    std::shared_ptr<ImguiText> blockTicksText = std::make_shared<ImguiText>(
+      [this]()
+      {
+        return std::format("Scheduled block ticks: {}", context_.scene->GetMap()->GetBlockTicks()->GetScheduledNumber());
+      }
+    );
+    window->AddElement(blockTicksText);
+
+    std::shared_ptr<ImguiText> pathText = std::make_shared<ImguiText>(
+      [this]()
+      {
+        int length = pathfindingModule_.GetLastPathLength();
+        return length < 0 ? std::string("Path ahead: searching") : std::format("Path ahead: {} steps", length);
+      }
+    );
+    window->AddElement(pathText);
+
+    std::shared_ptr<ImguiButton> pathButton = std::make_shared<ImguiButton>(
+      "Find path ahead",
+      [this]()
+      {
+        pathfindingModule_.RequestPathAhead(context_, 64.0f);
+      }
+    );
+    window->AddElement(pathButton);
+
+    std::shared_ptr<ImguiButton> spawnButton = std::make_shared<ImguiButton>(
+      "Spawn entities",
+      [this]()
+      {
+        entityModule_.SpawnSwarm(context_, 1000);
+      }
+    );
+    window->AddElement(spawnButton);
+
+    std::shared_ptr<ImguiButton> particlesButton = std::make_shared<ImguiButton>(
+      "Emit particles",
+      [this]()
+      {
+        particleModule_.EmitCloud(context_, 100000);
+      }
+    );
+    window->AddElement(particlesButton);
+
     std::shared_ptr<ImguiButton> saveButton = std::make_shared<ImguiButton>(
       "Save world",
       [this]()
       {
-        if (!blocks::isPathExist("map"))
-        {
-          blocks::createDirectory("map");
-        }
-        else
-        {
-          for (const std::string& path : blocks::getFilesInDirectory("map"))
-          {
-            blocks::removePath(path);
-          }
-        }
-
-        Map::Save(context_.scene->GetMap());
+        mapSavingModule_.RequestSave(context_.scene->GetMap());
       }
     );
     window->AddElement(saveButton);
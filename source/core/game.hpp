@@ -10,6 +10,12 @@
 #include "render/opengl_render_module.hpp"
 #include "player_control_module.hpp"
 #include "map_loading_module.hpp"
+#include "map_saving_module.hpp"
+#include "entity_module.hpp"
+#include "fluid_module.hpp"
+#include "pathfinding_module.hpp"
+#include "particle_module.hpp"
+#include "block_tick_module.hpp"
 
 
 namespace blocks
@@ -50,5 +56,11 @@ namespace blocks
     OpenglRenderModule renderModule_;
     PlayerControlModule playerControlModule_;
     MapLoadingModule mapLoadingModule_;
+    MapSavingModule mapSavingModule_;
+    EntityModule entityModule_;
+    FluidModule fluidModule_;
+    PathfindingModule pathfindingModule_;
+    ParticleModule particleModule_;
+    BlockTickModule blockTickModule_;
   };
 }
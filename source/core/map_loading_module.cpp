@@ -1,5 +1,13 @@
 #include "map_loading_module.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <numeric>
+#include <set>
+
+#include "environment.hpp"
+
 
 namespace blocks
 {
@@ -22,9 +30,16 @@ namespace blocks
 
       if (centerChunk != lastCenterChunkCoords_)
       {
+        context.scene->GetMap()->SetActiveArea(std::make_pair(centerChunk.x, centerChunk.y), loadingRadius_);
         RemoveChunks(centerChunk, lastCenterChunkCoords_);
         AddChunks(centerChunk, context.scene->GetMap());
 
+        // Neighbours of the loaded area stay resident for meshing
+        std::shared_ptr<Map> map = context.scene->GetMap();
+        std::pair<int, int> center = std::make_pair(centerChunk.x, centerChunk.y);
+        int radius = loadingRadius_ + 1;
+        Environment::GetIoService().Submit([map, center, radius]() { map->EvictChunks(center, radius); });
+
         lastCenterChunkCoords_ = centerChunk;
       }
     }
@@ -38,13 +53,84 @@ namespace blocks
 
       std::shared_ptr<Map> map = context.scene->GetMap();
       std::shared_ptr<OpenglMap> openglMap = context.openglScene->GetMap();
+
+      // Chunks are loaded on the I/O service while the ones already loaded are meshed
+      AsyncIoService& ioService = Environment::GetIoService();
+      std::vector<std::future<std::shared_ptr<const Chunk>>> chunks;
+      chunks.reserve(chunksToAdd_.size());
       for (const std::pair<int, int>& coordinates : chunksToAdd_)
       {
-        std::shared_ptr<Chunk> chunk = map->GetChunk(coordinates);
-        openglMap->EnqueueChunkAdd(chunk, coordinates);
+        chunks.push_back(ioService.Submit([map, coordinates]() { return map->GetChunk(coordinates); }));
+      }
+
+      // Light spreading from the new chunks changes meshes of the chunks around them. Relit chunks are collected
+      // before every mesh, a chunk meshed after its last relight does not need another one.
+      std::set<std::pair<int, int>> relitChunks;
+      auto takeRelitChunks = [&map, &relitChunks]()
+      {
+        for (const std::pair<int, int>& coordinates : map->TakeRelitChunks())
+        {
+          relitChunks.insert(coordinates);
+        }
+      };
+
+      // Each chunk is meshed as soon as its load completes, whatever the order they were submitted in.
+      // Chunks whose spill could not be read are tried again on the next call.
+      std::vector<size_t> loadingChunks(chunks.size());
+      std::iota(loadingChunks.begin(), loadingChunks.end(), 0);
+      std::vector<std::pair<int, int>> failedChunks;
+      std::set<std::pair<int, int>> addedChunks;
+      while (!loadingChunks.empty())
+      {
+        bool isAnyLoaded = false;
+        for (size_t i = 0; i < loadingChunks.size(); )
+        {
+          size_t index = loadingChunks[i];
+          if (chunks[index].wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+          {
+            i++;
+            continue;
+          }
+          loadingChunks[i] = loadingChunks.back();
+          loadingChunks.pop_back();
+          isAnyLoaded = true;
+
+          std::pair<int, int> coordinates = chunksToAdd_[index];
+          std::shared_ptr<const Chunk> chunk = chunks[index].get();
+          if (!chunk)
+          {
+            failedChunks.push_back(coordinates);
+            continue;
+          }
+
+          takeRelitChunks();
+          openglMap->EnqueueChunkAdd(chunk, map->GetLightView(coordinates), coordinates);
+          relitChunks.erase(coordinates);
+          addedChunks.insert(coordinates);
+
+          // Fluid that reached the chunk while it was away flows on
+          context.scene->GetFluids()->AttachChunk(coordinates);
+        }
+
+        if (!isAnyLoaded)
+        {
+          chunks[loadingChunks.front()].wait();
+        }
+      }
+
+      // Chunks changed by the simulation are meshed here too, off the simulation thread
+      takeRelitChunks();
+      relitChunks.merge(openglMap->TakeChunksToRemesh());
+      for (const std::pair<int, int>& coordinates : relitChunks)
+      {
+        std::shared_ptr<const Chunk> chunk = map->FindChunk(coordinates);
+        if (chunk && (openglMap->ContainsChunk(coordinates) || addedChunks.contains(coordinates)))
+        {
+          openglMap->EnqueueChunkAdd(chunk, map->GetLightView(coordinates), coordinates);
+        }
       }
 
-      chunksToAdd_.clear();
+      chunksToAdd_ = std::move(failedChunks);
     }
   }
 
@@ -60,6 +146,7 @@ namespace blocks
     if (context.scene->ContainsMap())
     {
       lastCenterChunkCoords_ = CalculateChunkCenter(context.camera->GetPosition());
+      context.scene->GetMap()->SetActiveArea(std::make_pair(lastCenterChunkCoords_.x, lastCenterChunkCoords_.y), loadingRadius_);
       AddChunks(lastCenterChunkCoords_, context.scene->GetMap());
     }
   }
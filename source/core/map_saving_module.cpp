@@ -0,0 +1,161 @@
+#include "map_saving_module.hpp"
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "io/file_api.hpp"
+
+
+namespace blocks
+{
+  MapSavingModule::MapSavingModule()
+  {
+    thread_ = std::thread(&MapSavingModule::RunSavingCycle, this);
+  }
+
+  MapSavingModule::~MapSavingModule()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      isRunning_ = false;
+    }
+    condition_.notify_one();
+
+    thread_.join();
+  }
+
+
+  void MapSavingModule::Update(float delta, GameContext& context)
+  {
+    if (!context.scene->ContainsMap())
+    {
+      timeSinceAutosave_ = 0.0f;
+      return;
+    }
+
+    timeSinceAutosave_ += delta;
+    if (timeSinceAutosave_ < autosaveInterval_)
+    {
+      return;
+    }
+    timeSinceAutosave_ = 0.0f;
+
+    // Only worlds that already live on disk are autosaved, a new world must not overwrite the saved one
+    std::shared_ptr<Map> map = context.scene->GetMap();
+    if (map->GetMappedStore() || (map->GetStorage() && map->GetDirtyChunksNumber() > 0))
+    {
+      RequestSave(map);
+    }
+  }
+
+
+  void MapSavingModule::RequestSave(std::shared_ptr<Map> map)
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      requestedMap_ = map;
+    }
+    condition_.notify_one();
+  }
+
+  bool MapSavingModule::IsSaving()
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    return isSaving_ || requestedMap_ != nullptr;
+  }
+
+
+  void MapSavingModule::RunSavingCycle()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+      condition_.wait(lock, [this] { return !isRunning_ || requestedMap_ != nullptr; });
+      if (requestedMap_ == nullptr)
+      {
+        return;
+      }
+
+      std::shared_ptr<Map> map = requestedMap_;
+      requestedMap_ = nullptr;
+      isSaving_ = true;
+
+      lock.unlock();
+      SaveMap(map);
+      lock.lock();
+
+      isSaving_ = false;
+    }
+  }
+
+  void MapSavingModule::SaveMap(std::shared_ptr<Map> map)
+  {
+    std::shared_ptr<MappedWorldStore> mappedStore = map->GetMappedStore();
+    if (mappedStore)
+    {
+      // Edited versions are copied back to their slots, flushing makes them durable
+      for (const auto& [position, chunk, ticks] : map->TakeDirtyChunks())
+      {
+        if (mappedStore->StoreChunk(position, chunk, ticks))
+        {
+          map->MarkChunkSaved(position, chunk);
+        }
+        else
+        {
+          map->MarkChunkDirty(position);
+        }
+      }
+      mappedStore->Flush();
+      return;
+    }
+
+    std::shared_ptr<WorldStorage> storage = map->GetStorage();
+    if (!storage)
+    {
+      // A new world replaces whatever was saved before
+      blocks::removeDirectory("map");
+
+      storage = std::make_shared<WorldStorage>("map");
+      map->SetStorage(storage);
+    }
+
+    blocks::saveTextFile(storage->GetDirectory() + "/seed.txt", std::to_string(map->GetSeed()));
+
+    auto startTime = std::chrono::steady_clock::now();
+    size_t bytesWritten = 0;
+    std::vector<std::pair<std::pair<int, int>, std::shared_ptr<const Chunk>>> writtenChunks;
+    for (const auto& [position, chunk, ticks] : map->TakeDirtyChunks())
+    {
+      size_t size = storage->WriteChunk(position, *chunk, ticks);
+      if (size == 0)
+      {
+        map->MarkChunkDirty(position);
+        continue;
+      }
+      bytesWritten += size;
+      writtenChunks.emplace_back(position, chunk);
+
+      // Throttle to the bandwidth budget, but flush at full speed when shutting down
+      std::unique_lock<std::mutex> lock(mutex_);
+      auto targetTime = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>((double)bytesWritten / maxBytesPerSecond_));
+      condition_.wait_until(lock, targetTime, [this] { return !isRunning_; });
+    }
+
+    // Whole batch becomes durable at once, chunks are saved again if that fails
+    bool isCommitted = storage->Commit();
+    for (const auto& [position, chunk] : writtenChunks)
+    {
+      if (isCommitted)
+      {
+        map->MarkChunkSaved(position, chunk);
+      }
+      else
+      {
+        map->MarkChunkDirty(position);
+      }
+    }
+  }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "game_module_interface.hpp"
+#include "scene/map.hpp"
+
+
+namespace blocks
+{
+  // Writes dirty chunk snapshots to the world storage on a background thread
+  class MapSavingModule : public GameModuleInterface
+  {
+  public:
+    MapSavingModule();
+    MapSavingModule(const MapSavingModule&) = delete;
+    MapSavingModule(MapSavingModule&& other) = delete;
+    MapSavingModule& operator=(const MapSavingModule&) = delete;
+    MapSavingModule& operator=(MapSavingModule&& other) = delete;
+    ~MapSavingModule() override;
+
+    virtual void Update(float delta, GameContext& context) override;
+
+    void RequestSave(std::shared_ptr<Map> map);
+    bool IsSaving();
+
+  private:
+    void RunSavingCycle();
+    void SaveMap(std::shared_ptr<Map> map);
+
+    float autosaveInterval_ = 60.0f;
+    float timeSinceAutosave_ = 0.0f;
+    size_t maxBytesPerSecond_ = 4 * 1024 * 1024;
+
+    std::shared_ptr<Map> requestedMap_ = nullptr;
+    bool isSaving_ = false;
+    bool isRunning_ = true;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+    std::thread thread_;
+  };
+}
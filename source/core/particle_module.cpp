@@ -0,0 +1,38 @@
+#include "particle_module.hpp"
+
+
+namespace blocks
+{
+  ParticleModule::ParticleModule()
+  {
+
+  }
+
+  ParticleModule::~ParticleModule()
+  {
+
+  }
+
+
+  void ParticleModule::Update(float delta, GameContext& context)
+  {
+    if (context.scene->ContainsMap())
+    {
+      context.scene->GetParticles()->Update(delta, *context.scene->GetMap());
+    }
+  }
+
+  void ParticleModule::EmitCloud(GameContext& context, size_t particlesNumber)
+  {
+    if (!context.scene->ContainsMap())
+    {
+      return;
+    }
+
+    std::shared_ptr<const BlockRegistry> registry = context.scene->GetMap()->GetBlockRegistry();
+    float texture = registry && registry->GetBlocksNumber() > 1 ? registry->GetTexture(1, 0) : 0.0f;
+
+    glm::vec3 center = context.camera->GetPosition() + context.camera->GetForward() * 4.0f;
+    context.scene->GetParticles()->Emit(ParticleEffect::Debris, center, particlesNumber, texture, ChunkLight::Pack(ChunkLight::MaxLevel, 0));
+  }
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include "game_module_interface.hpp"
+
+
+namespace blocks
+{
+  // Steps the scene particles once per simulation tick
+  class ParticleModule : public GameModuleInterface
+  {
+  public:
+    ParticleModule();
+    ParticleModule(const ParticleModule&) = delete;
+    ParticleModule(ParticleModule&& other) = delete;
+    ParticleModule& operator=(const ParticleModule&) = delete;
+    ParticleModule& operator=(ParticleModule&& other) = delete;
+    ~ParticleModule() override;
+
+    virtual void Update(float delta, GameContext& context) override;
+
+    // Throws debris in front of the camera, used to stress the particles
+    void EmitCloud(GameContext& context, size_t particlesNumber);
+  };
+}
@@ -0,0 +1,140 @@
+#include "pathfinding_module.hpp"
+
+#include <chrono>
+
+
+namespace blocks
+{
+  PathfindingModule::PathfindingModule() : searchService_(SearchThreadsNumber)
+  {
+
+  }
+
+  PathfindingModule::~PathfindingModule()
+  {
+
+  }
+
+
+  void PathfindingModule::Update(float delta, GameContext& context)
+  {
+    if (!context.scene->ContainsMap())
+    {
+      return;
+    }
+
+    std::shared_ptr<Map> map = context.scene->GetMap();
+    std::shared_ptr<PathGraph> paths = context.scene->GetPaths();
+    for (const std::pair<int, int>& position : map->TakeEvictedChunks())
+    {
+      paths->ReleaseChunk(position);
+    }
+
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    tick_++;
+    for (auto it = paths_.begin(); it != paths_.end(); )
+    {
+      it = tick_ - it->second.foundTick > PathLifetime ? paths_.erase(it) : std::next(it);
+    }
+
+    for (size_t i = 0; i < runningRequests_.size(); )
+    {
+      auto& [id, path] = runningRequests_[i];
+      if (path.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+      {
+        i++;
+        continue;
+      }
+
+      paths_[id] = FoundPath{ path.get(), tick_ };
+      runningRequests_[i] = std::move(runningRequests_.back());
+      runningRequests_.pop_back();
+    }
+
+    if (isLastRequested_)
+    {
+      auto it = paths_.find(lastRequest_);
+      if (it != paths_.end())
+      {
+        lastPathLength_ = it->second.cells.empty() ? 0 : (int)it->second.cells.size() - 1;
+        paths_.erase(it);
+        isLastRequested_ = false;
+      }
+    }
+
+    // Tick budget, the rest waits for the next ticks
+    for (size_t started = 0; started < RequestsPerTick && runningRequests_.size() < MaxRunningRequests && !pendingRequests_.empty(); started++)
+    {
+      PathRequest request = pendingRequests_.front();
+      pendingRequests_.pop();
+
+      runningRequests_.emplace_back(request.id, searchService_.Submit([map, paths, request]() { return paths->FindPath(*map, request.start, request.goal); }));
+    }
+  }
+
+
+  PathRequestId PathfindingModule::RequestPath(glm::ivec3 start, glm::ivec3 goal)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    PathRequestId id = nextId_++;
+    pendingRequests_.push(PathRequest{ id, start, goal });
+    return id;
+  }
+
+  bool PathfindingModule::TakePath(PathRequestId id, std::vector<glm::ivec3>& path)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    auto it = paths_.find(id);
+    if (it == paths_.end())
+    {
+      return false;
+    }
+
+    path = std::move(it->second.cells);
+    paths_.erase(it);
+    return true;
+  }
+
+
+  void PathfindingModule::RequestPathAhead(GameContext& context, float distance)
+  {
+    if (!context.scene->ContainsMap())
+    {
+      return;
+    }
+
+    glm::vec3 position = context.camera->GetPosition();
+    glm::vec3 forward = context.camera->GetForward();
+    forward.z = 0.0f;
+    if (glm::length(forward) < 0.01f)
+    {
+      return;
+    }
+    glm::vec3 target = position + glm::normalize(forward) * distance;
+
+    std::shared_ptr<Map> map = context.scene->GetMap();
+    std::shared_ptr<PathGraph> paths = context.scene->GetPaths();
+    glm::ivec3 start;
+    glm::ivec3 goal;
+    bool isFound = paths->FindStandingCell(*map, glm::ivec3(glm::floor(position)), start) &&
+      paths->FindStandingCell(*map, glm::ivec3((int)glm::floor(target.x), (int)glm::floor(target.y), (int)Chunk::Height - 1), goal);
+
+    PathRequestId id = isFound ? RequestPath(start, goal) : 0;
+
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    lastRequest_ = id;
+    isLastRequested_ = isFound;
+    lastPathLength_ = isFound ? -1 : 0;
+  }
+
+  int PathfindingModule::GetLastPathLength()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return lastPathLength_;
+  }
+}
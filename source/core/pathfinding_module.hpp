@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "game_module_interface.hpp"
+#include "io/async_io_service.hpp"
+
+
+namespace blocks
+{
+  typedef std::uint32_t PathRequestId;
+
+  // Serves path requests on workers of its own, long searches never hold up chunk loading on the I/O service.
+  // Only a few searches start per simulation tick.
+  class PathfindingModule : public GameModuleInterface
+  {
+  public:
+    static const size_t RequestsPerTick = 2;
+    static const size_t SearchThreadsNumber = 2;
+    static const size_t MaxRunningRequests = SearchThreadsNumber;
+    // Found paths nobody took are dropped after this many ticks
+    static const std::uint64_t PathLifetime = 600;
+
+    PathfindingModule();
+    PathfindingModule(const PathfindingModule&) = delete;
+    PathfindingModule(PathfindingModule&& other) = delete;
+    PathfindingModule& operator=(const PathfindingModule&) = delete;
+    PathfindingModule& operator=(PathfindingModule&& other) = delete;
+    ~PathfindingModule() override;
+
+    virtual void Update(float delta, GameContext& context) override;
+
+    // Both cells must be cells an agent can stand in
+    PathRequestId RequestPath(glm::ivec3 start, glm::ivec3 goal);
+    // Returns false while the search is pending, an empty path means the goal is not reachable
+    bool TakePath(PathRequestId id, std::vector<glm::ivec3>& path);
+
+    // Asks for a path from the ground below the camera to the ground ahead of it, used to check navigation
+    void RequestPathAhead(GameContext& context, float distance);
+    // Steps of the last path asked for ahead, -1 while it is pending and 0 when there is none
+    int GetLastPathLength();
+
+  private:
+    struct PathRequest
+    {
+      PathRequestId id;
+      glm::ivec3 start;
+      glm::ivec3 goal;
+    };
+
+    struct FoundPath
+    {
+      std::vector<glm::ivec3> cells;
+      std::uint64_t foundTick;
+    };
+
+    PathRequestId nextId_ = 0;
+    std::uint64_t tick_ = 0;
+    std::queue<PathRequest> pendingRequests_;
+    std::vector<std::pair<PathRequestId, std::future<std::vector<glm::ivec3>>>> runningRequests_;
+    std::map<PathRequestId, FoundPath> paths_;
+    PathRequestId lastRequest_ = 0;
+    bool isLastRequested_ = false;
+    int lastPathLength_ = 0;
+    std::mutex mutex_;
+    // Declared last, so running searches finish before the rest of the module is destroyed
+    AsyncIoService searchService_;
+  };
+}
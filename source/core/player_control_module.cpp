@@ -50,11 +50,7 @@ namespace blocks
       shift += context.camera->GetRight() * velocity;
     }
 
-    position += shift;
-    if (!context.scene->GetMap()->Collides(context.playerBounds, position))
-    {
-      context.camera->SetPosition(position);
-    }
+    context.camera->SetPosition(context.scene->GetMap()->MoveBox(context.playerBounds, position, shift));
   }
 
   void PlayerControlModule::RotateCamera(const float delta, const InputState& inputState, GameContext& context)
@@ -77,6 +73,17 @@ namespace blocks
 
   void PlayerControlModule::ManageBlockPlacement(const float delta, const InputState& inputState, GameContext& context)
   {
+    // Number keys pick the block type to place
+    std::shared_ptr<const BlockRegistry> registry = context.scene->GetMap()->GetBlockRegistry();
+    for (int key = GLFW_KEY_1; key <= GLFW_KEY_9; key++)
+    {
+      Block block = (Block)(key - GLFW_KEY_0);
+      if (inputState.IsKeyJustPressed(key) && registry && block < registry->GetBlocksNumber())
+      {
+        placedBlock_ = block;
+      }
+    }
+
     if (inputState.IsMouseButtonJustPressed(GLFW_MOUSE_BUTTON_1))
     {
       if (context.scene->ContainsMap() && !context.isCursorEnabled)
@@ -87,81 +94,33 @@ namespace blocks
           return;
         }
 
+        // Neighbour across the hit face, possibly in the next chunk
         std::pair<int, int> placeChunkPosition = blockLookAt.chunkPosition;
-        glm::ivec3 placeBlockPosition = blockLookAt.blockPosition;
-        switch (blockLookAt.loockFromDirection)
+        glm::ivec3 placeBlockPosition = blockLookAt.blockPosition + blockLookAt.normal;
+        if (placeBlockPosition.z < 0 || placeBlockPosition.z >= (int)Chunk::Height)
+        {
+          return;
+        }
+        if (placeBlockPosition.x < 0 || placeBlockPosition.x >= (int)Chunk::Length)
+        {
+          placeChunkPosition.first += blockLookAt.normal.x;
+          placeBlockPosition.x -= blockLookAt.normal.x * (int)Chunk::Length;
+        }
+        if (placeBlockPosition.y < 0 || placeBlockPosition.y >= (int)Chunk::Width)
         {
-        case Direction::Forward:
-          if (blockLookAt.blockPosition.x == Chunk::Length - 1)
-          {
-            placeChunkPosition.first += 1;
-            placeBlockPosition.x = 0;
-          }
-          else
-          {
-            placeBlockPosition.x++;
-          }
-          break;
-        case Direction::Back:
-          if (blockLookAt.blockPosition.x == 0)
-          {
-            placeChunkPosition.first -= 1;
-            placeBlockPosition.x = 15;
-          }
-          else
-          {
-            placeBlockPosition.x--;
-          }
-          break;
-
-        case Direction::Right:
-          if (blockLookAt.blockPosition.y == Chunk::Width - 1)
-          {
-            placeChunkPosition.second += 1;
-            placeBlockPosition.y = 0;
-          }
-          else
-          {
-            placeBlockPosition.y++;
-          }
-          break;
-        case Direction::Left:
-          if (blockLookAt.blockPosition.y == 0)
-          {
-            placeChunkPosition.second -= 1;
-            placeBlockPosition.y = 15;
-          }
-          else
-          {
-            placeBlockPosition.y--;
-          }
-          break;
-
-        case Direction::Up:
-          if (blockLookAt.blockPosition.z == Chunk::Height - 1)
-          {
-            return;
-          }
-          else
-          {
-            placeBlockPosition.z++;
-          }
-          break;
-        case Direction::Down:
-          if (blockLookAt.blockPosition.z == 0)
-          {
-            return;
-          }
-          else
-          {
-            placeBlockPosition.z--;
-          }
-          break;
+          placeChunkPosition.second += blockLookAt.normal.y;
+          placeBlockPosition.y -= blockLookAt.normal.y * (int)Chunk::Width;
         }
 
-        std::shared_ptr<Chunk> chunk = context.scene->GetMap()->GetChunk(placeChunkPosition);
-        chunk->blocks[placeBlockPosition.x + placeBlockPosition.y * Chunk::Width + placeBlockPosition.z * Chunk::LayerBlocksNumber] = 1;
-        context.openglScene->AddChunk(chunk, placeChunkPosition);
+        std::shared_ptr<const Chunk> chunk = context.scene->GetMap()->SetBlock(placeChunkPosition, placeBlockPosition, placedBlock_);
+        if (!chunk)
+        {
+          return;
+        }
+        context.openglScene->AddChunk(chunk, context.scene->GetMap()->GetLightView(placeChunkPosition), placeChunkPosition);
+        glm::ivec3 cell = glm::ivec3(placeChunkPosition.first * (int)Chunk::Length, placeChunkPosition.second * (int)Chunk::Width, 0) + placeBlockPosition;
+        context.scene->GetFluids()->Activate(cell);
+        context.scene->GetPaths()->InvalidateCell(cell);
       }
     }
     else if (inputState.IsMouseButtonJustPressed(GLFW_MOUSE_BUTTON_2))
@@ -174,9 +133,30 @@ namespace blocks
           return;
         }
 
-        std::shared_ptr<Chunk> chunk = context.scene->GetMap()->GetChunk(blockLookAt.chunkPosition);
-        chunk->blocks[blockLookAt.blockPosition.x + blockLookAt.blockPosition.y * Chunk::Width + blockLookAt.blockPosition.z * Chunk::LayerBlocksNumber] = 0;
-        context.openglScene->AddChunk(chunk, blockLookAt.chunkPosition);
+        std::shared_ptr<const Chunk> oldChunk = context.scene->GetMap()->GetChunk(blockLookAt.chunkPosition);
+        if (!oldChunk)
+        {
+          return;
+        }
+        Block brokenBlock = oldChunk->blocks[blockLookAt.blockPosition.x + blockLookAt.blockPosition.y * Chunk::Width + blockLookAt.blockPosition.z * Chunk::LayerBlocksNumber];
+
+        std::shared_ptr<const Chunk> chunk = context.scene->GetMap()->SetBlock(blockLookAt.chunkPosition, blockLookAt.blockPosition, 0);
+        if (!chunk)
+        {
+          return;
+        }
+        ChunkLightView light = context.scene->GetMap()->GetLightView(blockLookAt.chunkPosition);
+        context.openglScene->AddChunk(chunk, light, blockLookAt.chunkPosition);
+        glm::ivec3 cell = glm::ivec3(blockLookAt.chunkPosition.first * (int)Chunk::Length, blockLookAt.chunkPosition.second * (int)Chunk::Width, 0) + blockLookAt.blockPosition;
+        context.scene->GetFluids()->Activate(cell);
+        context.scene->GetPaths()->InvalidateCell(cell);
+
+        // Debris and dust of the broken block, lit by the cell it leaves behind
+        std::shared_ptr<const BlockRegistry> registry = context.scene->GetMap()->GetBlockRegistry();
+        float texture = registry ? registry->GetTexture(brokenBlock, 0) : 0.0f;
+        glm::vec3 center = glm::vec3(cell) + glm::vec3(0.5f);
+        context.scene->GetParticles()->Emit(ParticleEffect::Debris, center, DebrisParticlesNumber, texture, light.Get(blockLookAt.blockPosition));
+        context.scene->GetParticles()->Emit(ParticleEffect::Dust, center, DustParticlesNumber, texture, light.Get(blockLookAt.blockPosition));
       }
     }
   }
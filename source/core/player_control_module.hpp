@@ -21,9 +21,14 @@ namespace blocks
     virtual void Update(const float delta, const InputState& inputState, GameContext& context);
 
   private:
+    static const size_t DebrisParticlesNumber = 48;
+    static const size_t DustParticlesNumber = 16;
+
     void MovePlayer(const float delta, const InputState& inputState, GameContext& context);
     void RotateCamera(const float delta, const InputState& inputState, GameContext& context);
     void ZoomCamera(const float delta, const InputState& inputState, GameContext& context);
     void ManageBlockPlacement(const float delta, const InputState& inputState, GameContext& context);
+
+    Block placedBlock_ = 1;
   };
 }
\ No newline at end of file
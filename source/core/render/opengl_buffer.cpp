@@ -32,9 +32,9 @@ namespace blocks
   }
 
 
-  void OpenglBuffer::SetData(GLsizeiptr size, const void* data)
+  void OpenglBuffer::SetData(GLsizeiptr size, const void* data, GLenum usage)
   {
-    glBufferData(bufferType_, size, data, GL_STATIC_DRAW);
+    glBufferData(bufferType_, size, data, usage);
   }
 
   void OpenglBuffer::Bind()
@@ -15,7 +15,7 @@ namespace blocks
     OpenglBuffer& operator=(OpenglBuffer&& other);
     ~OpenglBuffer();
 
-    void SetData(GLsizeiptr size, const void* data);
+    void SetData(GLsizeiptr size, const void* data, GLenum usage = GL_STATIC_DRAW);
     void Bind();
 
   private:
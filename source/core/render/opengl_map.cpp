@@ -1,12 +1,13 @@
 #include "opengl_map.hpp"
 
 #include <algorithm>
+#include <cmath>
 
 #include <glm/glm.hpp>
 
 #include "environment.hpp"
 #include "chunk.hpp"
-#include "resource/image.hpp"
+#include "resource/texture_array.hpp"
 
 
 namespace blocks
@@ -28,14 +29,8 @@ namespace blocks
 
     ResourceBase& resourceBase = Environment::GetResource();
 
-    std::vector<Image> images;
-    for (int i = 0; i < blockSet->GetTexturesNumber(); i++)
-    {
-      images.push_back(resourceBase.ReadImage(blockSet->GetTexture(i)));
-    }
-
-    int resolution = blockSet->GetResolution();
-    blocksTextureArray_ = std::make_shared<OpenglTexture2DArray>(images, resolution, resolution);
+    TextureArray textureArray = resourceBase.LoadBlockSetTextures(blockSet);
+    blocksTextureArray_ = std::make_shared<OpenglTexture2DArray>(textureArray);
     blocksTextureArray_->Bind(0);
   }
 
@@ -50,9 +45,15 @@ namespace blocks
     return chunks_.contains(position);
   }
 
-  void OpenglMap::EnqueueChunkAdd(std::shared_ptr<Chunk> chunk, std::pair<int, int> position)
+  void OpenglMap::EnqueueChunkAdd(std::shared_ptr<const Chunk> chunk, const ChunkLightView& light, std::pair<int, int> position)
   {
-    std::shared_ptr<OpenglRawChunkData> rawData = GenerateRawChunkData(chunk);
+    // Nothing to mesh with when no block set could be loaded
+    if (!HasBlockSet())
+    {
+      return;
+    }
+
+    std::shared_ptr<OpenglRawChunkData> rawData = GenerateRawChunkData(chunk, light);
     ChunksQueueItem item(rawData, position);
 
     std::lock_guard<std::mutex> locker(mutex_);
@@ -65,6 +66,18 @@ namespace blocks
     removeQueue_.push(position);
   }
 
+  void OpenglMap::EnqueueChunkRemesh(std::pair<int, int> position)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+    remeshQueue_.insert(position);
+  }
+
+  std::set<std::pair<int, int>> OpenglMap::TakeChunksToRemesh()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+    return std::move(remeshQueue_);
+  }
+
   void OpenglMap::ProcessQueues()
   {
     std::lock_guard<std::mutex> locker(mutex_);
@@ -91,6 +104,7 @@ namespace blocks
     float texU;
     float texV;
     float texI;
+    float light;
   };
 
   void AddVertex(Vertex& vertex, float* data, size_t& index)
@@ -101,15 +115,49 @@ namespace blocks
     data[index++] = vertex.texU;
     data[index++] = vertex.texV;
     data[index++] = vertex.texI;
+    data[index++] = vertex.light;
   }
 
+  // Smooth light of a face corner from the four cells in front of the face around it
+  float GetVertexLight(const ChunkLightView& light, glm::ivec3 faceCell, glm::ivec3 corner, int axis)
+  {
+    int u = (axis + 1) % 3;
+    int v = (axis + 2) % 3;
 
-  std::shared_ptr<OpenglRawChunkData> OpenglMap::GenerateRawChunkData(std::shared_ptr<Chunk> chunk)
+    int levelsSum = 0;
+    int litNumber = 0;
+    for (int du = -1; du <= 0; du++)
+    {
+      for (int dv = -1; dv <= 0; dv++)
+      {
+        glm::ivec3 cell = faceCell;
+        cell[u] = corner[u] + du;
+        cell[v] = corner[v] + dv;
+
+        // Opaque cells hold no light, they are left out instead of darkening the corner
+        std::uint8_t cellLight = light.Get(cell);
+        int level = std::max(ChunkLight::GetSkyLevel(cellLight), ChunkLight::GetBlockLevel(cellLight));
+        if (level != 0)
+        {
+          levelsSum += level;
+          litNumber++;
+        }
+      }
+    }
+
+    float level = litNumber != 0 ? (float)levelsSum / litNumber : 0.0f;
+    return 0.05f + 0.95f * std::pow(0.8f, ChunkLight::MaxLevel - level);
+  }
+
+
+  std::shared_ptr<OpenglRawChunkData> OpenglMap::GenerateRawChunkData(std::shared_ptr<const Chunk> chunk, const ChunkLightView& light)
   {
     static const size_t BlockVerticesNumber = 4 * 6;
-    static const size_t VertexSize = sizeof(float) * 6;
+    static const size_t VertexSize = sizeof(float) * 7;
     static const size_t verticesDataSize = Chunk::BlocksNumber * BlockVerticesNumber * VertexSize;
 
+    const BlockRegistry& registry = *blockSet_->GetRegistry();
+
     float* verticesData = new float[verticesDataSize];
     size_t verticesDataIndex = 0;
     size_t verticesNumber = 0;
@@ -121,24 +169,24 @@ namespace blocks
         {
           size_t blockIndex = x + y * Chunk::Width + z * Chunk::LayerBlocksNumber;
 
-          if (chunk->blocks[blockIndex] == 0)
+          Block block = chunk->blocks[blockIndex];
+          if (block == 0)
           {
             continue;
           }
 
-          BlockInfo fBlock = blockSet_->GetBlockInfo(chunk->blocks[blockIndex] - 1);
-
           glm::vec3 position(x, y, z);
 
           // Check forward face
-          if (x == Chunk::Length - 1 || chunk->blocks[blockIndex + 1] == 0)
+          if (x == Chunk::Length - 1 || !registry.IsOpaque(chunk->blocks[blockIndex + 1]))
           {
             // Add forward face
 
-            Vertex v1(x + 1, y + 1, z, 0.0f, 0.0f, fBlock.textures[0]);
-            Vertex v2(x + 1, y, z, 1.0f, 0.0f, fBlock.textures[0]);
-            Vertex v3(x + 1, y + 1, z + 1, 0.0f, 1.0f, fBlock.textures[0]);
-            Vertex v4(x + 1, y, z + 1, 1.0f, 1.0f, fBlock.textures[0]);
+            float texture = registry.GetTexture(block, 0);
+            Vertex v1(x + 1, y + 1, z, 0.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x + 1, y, z), glm::ivec3(x + 1, y + 1, z), 0));
+            Vertex v2(x + 1, y, z, 1.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x + 1, y, z), glm::ivec3(x + 1, y, z), 0));
+            Vertex v3(x + 1, y + 1, z + 1, 0.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x + 1, y, z), glm::ivec3(x + 1, y + 1, z + 1), 0));
+            Vertex v4(x + 1, y, z + 1, 1.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x + 1, y, z), glm::ivec3(x + 1, y, z + 1), 0));
 
             AddVertex(v1, verticesData, verticesDataIndex);
             AddVertex(v2, verticesData, verticesDataIndex);
@@ -151,14 +199,15 @@ namespace blocks
           }
 
           // Check backward face
-          if (x == 0 || chunk->blocks[blockIndex - 1] == 0)
+          if (x == 0 || !registry.IsOpaque(chunk->blocks[blockIndex - 1]))
           {
             // Add backward face
 
-            Vertex v1(x, y, z, 0.0f, 0.0f, fBlock.textures[1]);
-            Vertex v2(x, y + 1, z, 1.0f, 0.0f, fBlock.textures[1]);
-            Vertex v3(x, y, z + 1, 0.0f, 1.0f, fBlock.textures[1]);
-            Vertex v4(x, y + 1, z + 1, 1.0f, 1.0f, fBlock.textures[1]);
+            float texture = registry.GetTexture(block, 1);
+            Vertex v1(x, y, z, 0.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x - 1, y, z), glm::ivec3(x, y, z), 0));
+            Vertex v2(x, y + 1, z, 1.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x - 1, y, z), glm::ivec3(x, y + 1, z), 0));
+            Vertex v3(x, y, z + 1, 0.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x - 1, y, z), glm::ivec3(x, y, z + 1), 0));
+            Vertex v4(x, y + 1, z + 1, 1.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x - 1, y, z), glm::ivec3(x, y + 1, z + 1), 0));
 
             AddVertex(v1, verticesData, verticesDataIndex);
             AddVertex(v2, verticesData, verticesDataIndex);
@@ -171,14 +220,15 @@ namespace blocks
           }
 
           // Check right face
-          if (y == Chunk::Width - 1 || chunk->blocks[blockIndex + Chunk::Length] == 0)
+          if (y == Chunk::Width - 1 || !registry.IsOpaque(chunk->blocks[blockIndex + Chunk::Length]))
           {
             // Add right face
 
-            Vertex v1(x, y + 1, z, 0.0f, 0.0f, fBlock.textures[2]);
-            Vertex v2(x + 1, y + 1, z, 1.0f, 0.0f, fBlock.textures[2]);
-            Vertex v3(x, y + 1, z + 1, 0.0f, 1.0f, fBlock.textures[2]);
-            Vertex v4(x + 1, y + 1, z + 1, 1.0f, 1.0f, fBlock.textures[2]);
+            float texture = registry.GetTexture(block, 2);
+            Vertex v1(x, y + 1, z, 0.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x, y + 1, z), glm::ivec3(x, y + 1, z), 1));
+            Vertex v2(x + 1, y + 1, z, 1.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x, y + 1, z), glm::ivec3(x + 1, y + 1, z), 1));
+            Vertex v3(x, y + 1, z + 1, 0.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x, y + 1, z), glm::ivec3(x, y + 1, z + 1), 1));
+            Vertex v4(x + 1, y + 1, z + 1, 1.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x, y + 1, z), glm::ivec3(x + 1, y + 1, z + 1), 1));
 
             AddVertex(v1, verticesData, verticesDataIndex);
             AddVertex(v2, verticesData, verticesDataIndex);
@@ -191,14 +241,15 @@ namespace blocks
           }
 
           // Check left face
-          if (y == 0 || chunk->blocks[blockIndex - Chunk::Length] == 0)
+          if (y == 0 || !registry.IsOpaque(chunk->blocks[blockIndex - Chunk::Length]))
           {
             // Add left face
 
-            Vertex v1(x + 1, y, z, 0.0f, 0.0f, fBlock.textures[3]);
-            Vertex v2(x, y, z, 1.0f, 0.0f, fBlock.textures[3]);
-            Vertex v3(x + 1, y, z + 1, 0.0f, 1.0f, fBlock.textures[3]);
-            Vertex v4(x, y, z + 1, 1.0f, 1.0f, fBlock.textures[3]);
+            float texture = registry.GetTexture(block, 3);
+            Vertex v1(x + 1, y, z, 0.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x, y - 1, z), glm::ivec3(x + 1, y, z), 1));
+            Vertex v2(x, y, z, 1.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x, y - 1, z), glm::ivec3(x, y, z), 1));
+            Vertex v3(x + 1, y, z + 1, 0.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x, y - 1, z), glm::ivec3(x + 1, y, z + 1), 1));
+            Vertex v4(x, y, z + 1, 1.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x, y - 1, z), glm::ivec3(x, y, z + 1), 1));
 
             AddVertex(v1, verticesData, verticesDataIndex);
             AddVertex(v2, verticesData, verticesDataIndex);
@@ -211,14 +262,15 @@ namespace blocks
           }
 
           // Check upper face
-          if (z == Chunk::Height - 1 || chunk->blocks[blockIndex + Chunk::LayerBlocksNumber] == 0)
+          if (z == Chunk::Height - 1 || !registry.IsOpaque(chunk->blocks[blockIndex + Chunk::LayerBlocksNumber]))
           {
             // Add upper face
 
-            Vertex v1(x + 1, y, z + 1, 0.0f, 0.0f, fBlock.textures[4]);
-            Vertex v2(x, y, z + 1, 1.0f, 0.0f, fBlock.textures[4]);
-            Vertex v3(x + 1, y + 1, z + 1, 0.0f, 1.0f, fBlock.textures[4]);
-            Vertex v4(x, y + 1, z + 1, 1.0f, 1.0f, fBlock.textures[4]);
+            float texture = registry.GetTexture(block, 4);
+            Vertex v1(x + 1, y, z + 1, 0.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x, y, z + 1), glm::ivec3(x + 1, y, z + 1), 2));
+            Vertex v2(x, y, z + 1, 1.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x, y, z + 1), glm::ivec3(x, y, z + 1), 2));
+            Vertex v3(x + 1, y + 1, z + 1, 0.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x, y, z + 1), glm::ivec3(x + 1, y + 1, z + 1), 2));
+            Vertex v4(x, y + 1, z + 1, 1.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x, y, z + 1), glm::ivec3(x, y + 1, z + 1), 2));
 
             AddVertex(v1, verticesData, verticesDataIndex);
             AddVertex(v2, verticesData, verticesDataIndex);
@@ -231,14 +283,15 @@ namespace blocks
           }
 
           // Check bottom face
-          if (z == 0 || chunk->blocks[blockIndex - Chunk::LayerBlocksNumber] == 0)
+          if (z == 0 || !registry.IsOpaque(chunk->blocks[blockIndex - Chunk::LayerBlocksNumber]))
           {
             // Add bottom face
 
-            Vertex v1(x, y, z, 0.0f, 0.0f, fBlock.textures[5]);
-            Vertex v2(x + 1, y, z, 1.0f, 0.0f, fBlock.textures[5]);
-            Vertex v3(x, y + 1, z, 0.0f, 1.0f, fBlock.textures[5]);
-            Vertex v4(x + 1, y + 1, z, 1.0f, 1.0f, fBlock.textures[5]);
+            float texture = registry.GetTexture(block, 5);
+            Vertex v1(x, y, z, 0.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x, y, z - 1), glm::ivec3(x, y, z), 2));
+            Vertex v2(x + 1, y, z, 1.0f, 0.0f, texture, GetVertexLight(light, glm::ivec3(x, y, z - 1), glm::ivec3(x + 1, y, z), 2));
+            Vertex v3(x, y + 1, z, 0.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x, y, z - 1), glm::ivec3(x, y + 1, z), 2));
+            Vertex v4(x + 1, y + 1, z, 1.0f, 1.0f, texture, GetVertexLight(light, glm::ivec3(x, y, z - 1), glm::ivec3(x + 1, y + 1, z), 2));
 
             AddVertex(v1, verticesData, verticesDataIndex);
             AddVertex(v2, verticesData, verticesDataIndex);
@@ -265,10 +318,12 @@ namespace blocks
     vbo->Bind();
     vbo->SetData(sizeof(float) * item.chunkData->verticesDataLength, item.chunkData->verticesData);
 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)0);
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(3 * sizeof(float)));
     glEnableVertexAttribArray(1);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, 7 * sizeof(float), (void*)(6 * sizeof(float)));
+    glEnableVertexAttribArray(2);
 
     std::shared_ptr<OpenglChunk> chunk = std::make_shared<OpenglChunk>(vbo, vao, item.chunkData->verticesNumber);
     chunks_[item.position] = chunk;
@@ -4,11 +4,13 @@
 #include <queue>
 #include <memory>
 #include <mutex>
+#include <set>
 
 #include "opengl_chunk.hpp"
 #include "opengl_raw_chunk_data.hpp"
 #include "render/opengl_texture_2d_array.hpp"
 #include "chunk.hpp"
+#include "scene/chunk_light.hpp"
 #include "resource/block_set.hpp"
 
 
@@ -34,19 +36,23 @@ namespace blocks
     bool HasBlockSet();
 
     bool ContainsChunk(std::pair<int, int> position);
-    void EnqueueChunkAdd(std::shared_ptr<Chunk> chunk, std::pair<int, int> position);
+    void EnqueueChunkAdd(std::shared_ptr<const Chunk> chunk, const ChunkLightView& light, std::pair<int, int> position);
     void EnqueueChunkRemove(std::pair<int, int> position);
+    // Chunks whose blocks changed, the render update thread meshes each of them once whatever the number of requests
+    void EnqueueChunkRemesh(std::pair<int, int> position);
+    std::set<std::pair<int, int>> TakeChunksToRemesh();
     void ProcessQueues();
 
   private:
     std::map<std::pair<int, int>, std::shared_ptr<OpenglChunk>> chunks_;
     std::queue<ChunksQueueItem> addQueue_;
     std::queue<std::pair<int, int>> removeQueue_;
+    std::set<std::pair<int, int>> remeshQueue_;
     std::mutex mutex_;
     std::shared_ptr<BlockSet> blockSet_;
     std::shared_ptr<OpenglTexture2DArray> blocksTextureArray_;
 
-    std::shared_ptr<OpenglRawChunkData> GenerateRawChunkData(std::shared_ptr<Chunk> chunk);
+    std::shared_ptr<OpenglRawChunkData> GenerateRawChunkData(std::shared_ptr<const Chunk> chunk, const ChunkLightView& light);
     void AddChunk(ChunksQueueItem& item);
     void RemoveChunk(std::pair<int, int> position);
   };
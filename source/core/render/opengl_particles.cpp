@@ -0,0 +1,57 @@
+#include "opengl_particles.hpp"
+
+#include <cstddef>
+
+
+namespace blocks
+{
+  OpenglParticles::OpenglParticles()
+  {
+    // Triangle strip of a unit quad centered on the particle
+    const float corners[] = {
+      -0.5f, -0.5f,
+      0.5f, -0.5f,
+      -0.5f, 0.5f,
+      0.5f, 0.5f
+    };
+
+    quadVbo_ = std::make_shared<OpenglBuffer>(GL_ARRAY_BUFFER);
+    instanceVbo_ = std::make_shared<OpenglBuffer>(GL_ARRAY_BUFFER);
+    vao_ = std::make_shared<OpenglVertexArrayObject>();
+
+    vao_->Bind();
+
+    quadVbo_->Bind();
+    quadVbo_->SetData(sizeof(corners), corners);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    instanceVbo_->Bind();
+    instanceVbo_->SetData(0, nullptr, GL_STREAM_DRAW);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribDivisor(1, 1);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(ParticleInstance), (void*)offsetof(ParticleInstance, texture));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+  }
+
+  OpenglParticles::~OpenglParticles()
+  {
+
+  }
+
+
+  void OpenglParticles::Upload(ParticleWorld& particles)
+  {
+    if (!particles.TakeInstances(instances_))
+    {
+      return;
+    }
+
+    // Respecified every time, the driver hands out fresh storage instead of waiting for the previous draw
+    instanceVbo_->Bind();
+    instanceVbo_->SetData(sizeof(ParticleInstance) * instances_.size(), instances_.data(), GL_STREAM_DRAW);
+    instancesNumber_ = (int)instances_.size();
+  }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "render/opengl_buffer.hpp"
+#include "render/opengl_vertex_array_object.hpp"
+#include "scene/particle_world.hpp"
+
+
+namespace blocks
+{
+  class OpenglRenderModule;
+
+  // Particles drawn as camera facing quads, one instance per particle and a single draw call
+  class OpenglParticles
+  {
+    friend OpenglRenderModule;
+
+  public:
+    OpenglParticles();
+    OpenglParticles(const OpenglParticles&) = delete;
+    OpenglParticles(OpenglParticles&& other) = delete;
+    OpenglParticles& operator=(const OpenglParticles&) = delete;
+    OpenglParticles& operator=(OpenglParticles&& other) = delete;
+    ~OpenglParticles();
+
+    // Streams the particles of the last simulation tick into the instance buffer, does nothing when they did not change
+    void Upload(ParticleWorld& particles);
+
+  private:
+    std::shared_ptr<OpenglBuffer> quadVbo_;
+    std::shared_ptr<OpenglBuffer> instanceVbo_;
+    std::shared_ptr<OpenglVertexArrayObject> vao_;
+    std::vector<ParticleInstance> instances_;
+    int instancesNumber_ = 0;
+  };
+}
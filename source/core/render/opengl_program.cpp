@@ -10,10 +10,21 @@ namespace blocks
     id_ = glCreateProgram();
     glAttachShader(id_, vertexShader.GetId());
     glAttachShader(id_, fragmentShader.GetId());
+    if (GLEW_ARB_get_program_binary)
+    {
+      glProgramParameteri(id_, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(id_);
     CheckErrors();
   }
 
+  OpenglProgram::OpenglProgram(GLenum binaryFormat, std::span<const unsigned char> binary)
+  {
+    id_ = glCreateProgram();
+    glProgramBinary(id_, binaryFormat, binary.data(), (GLsizei)binary.size());
+    // Link status is checked by the caller, driver may reject binaries silently after an update
+  }
+
   OpenglProgram::OpenglProgram(OpenglProgram&& other) : id_(other.id_)
   {
     other.id_ = 0;
@@ -42,6 +53,30 @@ namespace blocks
   }
 
 
+  bool OpenglProgram::IsLinked() const
+  {
+    GLint success = GL_FALSE;
+    glGetProgramiv(id_, GL_LINK_STATUS, &success);
+
+    return success == GL_TRUE;
+  }
+
+  std::vector<unsigned char> OpenglProgram::GetBinary(GLenum& binaryFormat) const
+  {
+    std::vector<unsigned char> result;
+
+    GLint length = 0;
+    glGetProgramiv(id_, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length > 0)
+    {
+      result.resize(length);
+      glGetProgramBinary(id_, length, nullptr, &binaryFormat, &result[0]);
+    }
+
+    return result;
+  }
+
+
   void OpenglProgram::SetBool(const std::string& name, bool value) const
   {
     glUniform1i(glGetUniformLocation(id_, name.c_str()), (int)value);
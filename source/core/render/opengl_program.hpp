@@ -1,5 +1,8 @@
 #pragma once
 
+#include <span>
+#include <vector>
+
 #include <glm/glm.hpp>
 
 #include "glew_headers.hpp"
@@ -12,6 +15,7 @@ namespace blocks
   {
   public:
     OpenglProgram(const OpenglShader& vertexShader, const OpenglShader& fragmentShader);
+    OpenglProgram(GLenum binaryFormat, std::span<const unsigned char> binary);
     OpenglProgram(const OpenglProgram&) = delete;
     OpenglProgram(OpenglProgram&& other);
     OpenglProgram& operator=(const OpenglProgram&) = delete;
@@ -20,6 +24,9 @@ namespace blocks
 
     void Setup();
 
+    bool IsLinked() const;
+    std::vector<unsigned char> GetBinary(GLenum& binaryFormat) const;
+
     void SetBool(const std::string& name, bool value) const;
     void SetInt(const std::string& name, int value) const;
     void SetFloat(const std::string& name, float value) const;
@@ -0,0 +1,129 @@
+#include "opengl_program_cache.hpp"
+
+#include <format>
+#include <vector>
+
+#include "opengl_shader.hpp"
+#include "io/file_api.hpp"
+#include "hash/hash_api.hpp"
+
+
+namespace blocks
+{
+  OpenglProgramCache::OpenglProgramCache(std::string directory) : directory_(directory)
+  {
+    GLint formatsNumber = 0;
+    if (GLEW_ARB_get_program_binary)
+    {
+      glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatsNumber);
+    }
+    isSupported_ = formatsNumber > 0;
+
+    // Binaries are valid only for the driver that produced them
+    std::string driver;
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+    {
+      const GLubyte* value = glGetString(name);
+      if (value)
+      {
+        driver += (const char*)value;
+      }
+      driver += ";";
+    }
+    driverHash_ = blocks::computeHash(driver);
+
+    if (isSupported_ && !blocks::isPathExist(directory_))
+    {
+      blocks::createDirectory(directory_);
+    }
+  }
+
+  OpenglProgramCache::~OpenglProgramCache()
+  {
+
+  }
+
+
+  std::shared_ptr<OpenglProgram> OpenglProgramCache::LoadProgram(std::string_view vertexCode, std::string_view fragmentCode)
+  {
+    std::uint64_t sourceHash = blocks::computeHash(fragmentCode, blocks::computeHash(vertexCode));
+    std::string path = std::format("{0}{1:016x}.program", directory_, sourceHash);
+
+    if (isSupported_)
+    {
+      std::shared_ptr<OpenglProgram> program = ReadProgram(path, sourceHash);
+      if (program)
+      {
+        return program;
+      }
+    }
+
+    OpenglShader vertexShader(vertexCode, GL_VERTEX_SHADER);
+    OpenglShader fragmentShader(fragmentCode, GL_FRAGMENT_SHADER);
+    std::shared_ptr<OpenglProgram> program = std::make_shared<OpenglProgram>(vertexShader, fragmentShader);
+
+    if (isSupported_ && program->IsLinked())
+    {
+      WriteProgram(path, sourceHash, *program);
+    }
+
+    return program;
+  }
+
+
+  std::shared_ptr<OpenglProgram> OpenglProgramCache::ReadProgram(const std::string& path, std::uint64_t sourceHash)
+  {
+    if (!blocks::isPathExist(path))
+    {
+      return nullptr;
+    }
+
+    MappedFile file = blocks::mapFile(path);
+    std::span<const unsigned char> data = file.GetView();
+    if (data.size() < sizeof(ProgramHeader))
+    {
+      return nullptr;
+    }
+
+    ProgramHeader header;
+    memcpy(&header, data.data(), sizeof(ProgramHeader));
+    if (header.magic != Magic || header.version != Version ||
+      header.sourceHash != sourceHash || header.driverHash != driverHash_ ||
+      header.binarySize == 0 || data.size() != sizeof(ProgramHeader) + header.binarySize)
+    {
+      return nullptr;
+    }
+
+    std::shared_ptr<OpenglProgram> program = std::make_shared<OpenglProgram>(header.binaryFormat, data.subspan(sizeof(ProgramHeader)));
+    if (!program->IsLinked())
+    {
+      return nullptr;
+    }
+
+    return program;
+  }
+
+  void OpenglProgramCache::WriteProgram(const std::string& path, std::uint64_t sourceHash, const OpenglProgram& program)
+  {
+    GLenum binaryFormat = 0;
+    std::vector<unsigned char> binary = program.GetBinary(binaryFormat);
+    if (binary.empty())
+    {
+      return;
+    }
+
+    ProgramHeader header;
+    header.magic = Magic;
+    header.version = Version;
+    header.sourceHash = sourceHash;
+    header.driverHash = driverHash_;
+    header.binaryFormat = binaryFormat;
+    header.binarySize = (std::uint32_t)binary.size();
+
+    std::vector<unsigned char> data(sizeof(ProgramHeader) + binary.size());
+    memcpy(&data[0], &header, sizeof(ProgramHeader));
+    memcpy(&data[sizeof(ProgramHeader)], &binary[0], binary.size());
+
+    blocks::saveBinaryFile(path, data);
+  }
+}
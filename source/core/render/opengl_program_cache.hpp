@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "glew_headers.hpp"
+#include "opengl_program.hpp"
+
+
+namespace blocks
+{
+  class OpenglProgramCache
+  {
+  public:
+    OpenglProgramCache(std::string directory);
+    OpenglProgramCache(const OpenglProgramCache&) = delete;
+    OpenglProgramCache(OpenglProgramCache&& other) = delete;
+    OpenglProgramCache& operator=(const OpenglProgramCache&) = delete;
+    OpenglProgramCache& operator=(OpenglProgramCache&& other) = delete;
+    ~OpenglProgramCache();
+
+    // Loads linked program binary from disk or compiles sources and stores the result
+    std::shared_ptr<OpenglProgram> LoadProgram(std::string_view vertexCode, std::string_view fragmentCode);
+
+  private:
+    struct ProgramHeader
+    {
+      std::uint32_t magic;
+      std::uint32_t version;
+      std::uint64_t sourceHash;
+      std::uint64_t driverHash;
+      std::uint32_t binaryFormat;
+      std::uint32_t binarySize;
+    };
+
+    static const std::uint32_t Magic = 0x47525042; // "BPRG"
+    static const std::uint32_t Version = 1;
+
+    std::shared_ptr<OpenglProgram> ReadProgram(const std::string& path, std::uint64_t sourceHash);
+    void WriteProgram(const std::string& path, std::uint64_t sourceHash, const OpenglProgram& program);
+
+    std::string directory_;
+    std::uint64_t driverHash_ = 0;
+    bool isSupported_ = false;
+  };
+}
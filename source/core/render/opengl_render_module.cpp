@@ -33,12 +33,14 @@ namespace blocks
     }
 
     openglScene_->GetMap()->ProcessQueues();
+    openglScene_->GetParticles()->Upload(*context.scene->GetParticles());
 
     Clear();
 
     glm::ivec2 windowSize = context_->window_.GetSize();
     float ratio = (float)windowSize.x / (float)windowSize.y;
     RenderMap(openglScene_->GetMap(), mapProgram_, context.camera, ratio);
+    RenderParticles(openglScene_->GetParticles(), particlesProgram_, context.camera, ratio);
 
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
@@ -99,23 +101,38 @@ namespace blocks
     }
 
     // Load map shader program
-    std::string vertexCode = blocks::readTextFile(PPCAT(SHADERS_DIR, DEFAULT_VERTEX_SHADER));
-    std::string fragmentCode = blocks::readTextFile(PPCAT(SHADERS_DIR, DEFAULT_FRAGMENT_SHADER));
-    OpenglShader vertexShader(vertexCode, GL_VERTEX_SHADER);
-    OpenglShader fragmentShader(fragmentCode, GL_FRAGMENT_SHADER);
-    mapProgram_ = std::make_shared<OpenglProgram>(vertexShader, fragmentShader);
+    MappedFile vertexFile = blocks::mapFile(PPCAT(SHADERS_DIR, DEFAULT_VERTEX_SHADER));
+    MappedFile fragmentFile = blocks::mapFile(PPCAT(SHADERS_DIR, DEFAULT_FRAGMENT_SHADER));
+    std::string_view vertexCode((const char*)vertexFile.GetData(), vertexFile.GetSize());
+    std::string_view fragmentCode((const char*)fragmentFile.GetData(), fragmentFile.GetSize());
+    programCache_ = std::make_unique<OpenglProgramCache>(CACHE_DIR);
+    mapProgram_ = programCache_->LoadProgram(vertexCode, fragmentCode);
+
+    // Load particles shader program
+    MappedFile particleVertexFile = blocks::mapFile(PPCAT(SHADERS_DIR, PARTICLE_VERTEX_SHADER));
+    MappedFile particleFragmentFile = blocks::mapFile(PPCAT(SHADERS_DIR, PARTICLE_FRAGMENT_SHADER));
+    std::string_view particleVertexCode((const char*)particleVertexFile.GetData(), particleVertexFile.GetSize());
+    std::string_view particleFragmentCode((const char*)particleFragmentFile.GetData(), particleFragmentFile.GetSize());
+    particlesProgram_ = programCache_->LoadProgram(particleVertexCode, particleFragmentCode);
 
     openglScene_ = std::make_shared<OpenglScene>();
     openglScene_->InitMap();
+    openglScene_->InitParticles();
 
     ResourceBase& resourceBase = Environment::GetResource();
-    std::shared_ptr<BlockSet> blockSet = resourceBase.LoadBlockSet(resourceBase.GetBlockSetNames()->front());
-    openglScene_->GetMap()->SetBlockSet(blockSet);
+    std::shared_ptr<std::vector<std::string>> blockSetNames = resourceBase.GetBlockSetNames();
+    std::shared_ptr<BlockSet> blockSet = blockSetNames->empty() ? nullptr : resourceBase.LoadBlockSet(blockSetNames->front());
+    if (blockSet)
+    {
+      openglScene_->GetMap()->SetBlockSet(blockSet);
+    }
   }
 
   void OpenglRenderModule::FreeResources()
   {
     mapProgram_.reset();
+    particlesProgram_.reset();
+    programCache_.reset();
     openglScene_.reset();
   }
 
@@ -164,4 +181,28 @@ namespace blocks
       glDrawArrays(GL_TRIANGLES, 0, chunk->verticesNumber_);
     }
   }
+
+  void OpenglRenderModule::RenderParticles(std::shared_ptr<OpenglParticles> particles, std::shared_ptr<OpenglProgram> particlesProgram, std::shared_ptr<Camera> camera, float ratio)
+  {
+    if (particles->instancesNumber_ == 0)
+    {
+      return;
+    }
+
+    glm::mat4 projection = glm::perspective(glm::radians(camera->GetZoom()), ratio, 0.1f, 1000.0f);
+    glm::mat4 view = camera->GetViewMatrix();
+
+    particlesProgram->Setup();
+    particlesProgram->SetInt("texture0", 0);
+    particlesProgram->SetMat4("VP", projection * view);
+    // Rows of the view rotation are the camera axes in world space
+    particlesProgram->SetVec3("CameraRight", view[0][0], view[1][0], view[2][0]);
+    particlesProgram->SetVec3("CameraUp", view[0][1], view[1][1], view[2][1]);
+
+    // Quads face the camera, winding depends on the view
+    glDisable(GL_CULL_FACE);
+    particles->vao_->Bind();
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, particles->instancesNumber_);
+    glEnable(GL_CULL_FACE);
+  }
 }
@@ -7,6 +7,7 @@
 #include "render/glew_headers.hpp"
 #include "render/opengl_context.hpp"
 #include "render/opengl_program.hpp"
+#include "render/opengl_program_cache.hpp"
 #include "opengl_scene.hpp"
 #include "camera.hpp"
 
@@ -35,9 +36,12 @@ namespace blocks
     bool IsCorrectThread();
     void Clear(glm::vec4 color = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
     void RenderMap(std::shared_ptr<OpenglMap> map, std::shared_ptr<OpenglProgram> mapProgram, std::shared_ptr<Camera> camera, float ratio);
+    void RenderParticles(std::shared_ptr<OpenglParticles> particles, std::shared_ptr<OpenglProgram> particlesProgram, std::shared_ptr<Camera> camera, float ratio);
 
     std::unique_ptr<OpenglContext> context_;
+    std::unique_ptr<OpenglProgramCache> programCache_;
     std::shared_ptr<OpenglProgram> mapProgram_;
+    std::shared_ptr<OpenglProgram> particlesProgram_;
     std::shared_ptr<OpenglScene> openglScene_;
   };
 }
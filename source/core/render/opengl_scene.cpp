@@ -21,14 +21,19 @@ namespace blocks
     map_ = std::make_unique<OpenglMap>();
   }
 
-  void OpenglScene::AddChunk(std::shared_ptr<Chunk> chunk, std::pair<int, int> position)
+  void OpenglScene::InitParticles()
+  {
+    particles_ = std::make_shared<OpenglParticles>();
+  }
+
+  void OpenglScene::AddChunk(std::shared_ptr<const Chunk> chunk, const ChunkLightView& light, std::pair<int, int> position)
   {
     if (!map_)
     {
       throw std::exception("Map is not initialized");
     }
 
-    map_->EnqueueChunkAdd(chunk, position);
+    map_->EnqueueChunkAdd(chunk, light, position);
   }
 
   void OpenglScene::RemoveChunk(std::pair<int, int> position)
@@ -46,4 +51,9 @@ namespace blocks
   {
     return map_;
   }
+
+  std::shared_ptr<OpenglParticles> OpenglScene::GetParticles()
+  {
+    return particles_;
+  }
 }
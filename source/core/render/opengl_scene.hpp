@@ -4,6 +4,7 @@
 #include <utility>
 
 #include "opengl_map.hpp"
+#include "opengl_particles.hpp"
 #include "chunk.hpp"
 
 
@@ -20,12 +21,15 @@ namespace blocks
     ~OpenglScene();
 
     void InitMap();
-    void AddChunk(std::shared_ptr<Chunk> chunk, std::pair<int, int> position);
+    void InitParticles();
+    void AddChunk(std::shared_ptr<const Chunk> chunk, const ChunkLightView& light, std::pair<int, int> position);
     void RemoveChunk(std::pair<int, int> position);
 
     std::shared_ptr<OpenglMap> GetMap();
+    std::shared_ptr<OpenglParticles> GetParticles();
 
   private:
     std::shared_ptr<OpenglMap> map_;
+    std::shared_ptr<OpenglParticles> particles_;
   };
 }
@@ -5,12 +5,14 @@
 
 namespace blocks
 {
-  OpenglShader::OpenglShader(const std::string& shaderCode, GLuint shaderType) : shaderType_(shaderType)
+  OpenglShader::OpenglShader(std::string_view shaderCode, GLuint shaderType) : shaderType_(shaderType)
   {
-    const char* cShaderCode = shaderCode.c_str();
+    // Code may come straight from a mapped file, so it is passed with explicit length
+    const char* cShaderCode = shaderCode.data();
+    GLint length = (GLint)shaderCode.size();
 
     id_ = glCreateShader(shaderType);
-    glShaderSource(id_, 1, &cShaderCode, NULL);
+    glShaderSource(id_, 1, &cShaderCode, &length);
     glCompileShader(id_);
     CheckErrors();
   }
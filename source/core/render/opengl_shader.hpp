@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 
 #include "glew_headers.hpp"
 
@@ -10,7 +11,7 @@ namespace blocks
   class OpenglShader
   {
   public:
-    OpenglShader(const std::string& shaderCode, GLuint shaderType);
+    OpenglShader(std::string_view shaderCode, GLuint shaderType);
     OpenglShader(const OpenglShader&) = delete;
     OpenglShader(OpenglShader&& other);
     OpenglShader& operator=(const OpenglShader&) = delete;
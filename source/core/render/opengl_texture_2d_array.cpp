@@ -11,7 +11,7 @@ namespace blocks
   {
     glGenTextures(1, &id_);
     glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
-    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, resolutionX, resolutionY, 6, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA, resolutionX, resolutionY, (GLsizei)images.size(), 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
 
     for (int i = 0; i < images.size(); i++)
     {
@@ -23,15 +23,36 @@ namespace blocks
           channelsMode = GL_RGBA;
 
         glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, i, resolutionX, resolutionY, 1, channelsMode, GL_UNSIGNED_BYTE, &image.data[0]);
-        glGenerateMipmap(GL_TEXTURE_2D);
       }
       else
       {
         std::cout << "Failed to load texture" << std::endl;
       }
     }
+    glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
 
-    glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+    glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+  }
+
+  OpenglTexture2DArray::OpenglTexture2DArray(const TextureArray& textureArray)
+  {
+    glGenTextures(1, &id_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+
+    // Every level already holds all layers contiguously, so it is uploaded with a single call
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int level = 0; level < textureArray.mipLevels; level++)
+    {
+      int resolution = TextureArray::GetLevelResolution(textureArray.resolution, level);
+      const unsigned char* levelData = textureArray.data + textureArray.GetLevelOffset(level);
+
+      glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, resolution, resolution, textureArray.layers, 0, GL_RGBA, GL_UNSIGNED_BYTE, levelData);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, textureArray.mipLevels - 1);
+    glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
     glTexParameterf(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
   }
 
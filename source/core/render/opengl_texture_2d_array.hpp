@@ -5,6 +5,7 @@
 
 #include "glew_headers.hpp"
 #include "resource/image.hpp"
+#include "resource/texture_array.hpp"
 
 
 namespace blocks
@@ -13,6 +14,7 @@ namespace blocks
   {
   public:
     OpenglTexture2DArray(const std::vector<Image>& images, const int resolutionX, const int resolutionY);
+    OpenglTexture2DArray(const TextureArray& textureArray);
     OpenglTexture2DArray(const OpenglTexture2DArray&) = delete;
     OpenglTexture2DArray(OpenglTexture2DArray&& other);
     OpenglTexture2DArray& operator=(const OpenglTexture2DArray&) = delete;
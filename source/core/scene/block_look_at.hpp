@@ -22,6 +22,9 @@ namespace blocks
     bool hit = false;
     std::pair<int, int> chunkPosition;
     glm::ivec3 blockPosition;
+    // Outward normal of the face the ray entered through
+    glm::ivec3 normal = glm::ivec3(0);
+    float distance = 0.0f;
     Direction loockFromDirection;
   };
 }
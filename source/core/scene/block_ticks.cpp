@@ -0,0 +1,243 @@
+#include "block_ticks.hpp"
+
+#include <algorithm>
+#include <tuple>
+
+#include "map.hpp"
+#include "math_utils.hpp"
+
+
+namespace blocks
+{
+  BlockTicks::BlockTicks()
+  {
+
+  }
+
+
+  void BlockTicks::Schedule(glm::ivec3 cell, std::uint32_t delay)
+  {
+    if (cell.z < 0 || cell.z >= (int)Chunk::Height)
+    {
+      return;
+    }
+
+    std::pair<int, int> chunkPosition = std::make_pair(floorDivide(cell.x, Chunk::Length), floorDivide(cell.y, Chunk::Width));
+    glm::ivec3 blockPosition = cell - glm::ivec3(chunkPosition.first * (int)Chunk::Length, chunkPosition.second * (int)Chunk::Width, 0);
+    std::uint32_t index = blockPosition.x + blockPosition.y * Chunk::Width + blockPosition.z * Chunk::LayerBlocksNumber;
+
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    Insert(chunkPosition, index, wheel_.GetTick() + std::max<std::uint32_t>(delay, 1));
+  }
+
+  size_t BlockTicks::GetScheduledNumber()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return scheduledNumber_;
+  }
+
+
+  void BlockTicks::AttachChunk(std::pair<int, int> position, const std::vector<ScheduledTick>& ticks)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    std::uint64_t tick = wheel_.GetTick();
+    for (const ScheduledTick& scheduledTick : ticks)
+    {
+      if (scheduledTick.index < Chunk::BlocksNumber)
+      {
+        Insert(position, scheduledTick.index, tick + std::max<std::uint32_t>(scheduledTick.delay, 1));
+      }
+    }
+
+    // Updates that came due while the chunk was away run on the next tick
+    auto listIt = chunkTicks_.find(position);
+    if (listIt == chunkTicks_.end())
+    {
+      return;
+    }
+    for (auto& [index, dueTick] : listIt->second)
+    {
+      if (dueTick <= tick)
+      {
+        dueTick = tick + 1;
+        wheel_.Schedule(dueTick, TickItem{ position, index });
+      }
+    }
+  }
+
+  std::vector<ScheduledTick> BlockTicks::GetChunkTicks(std::pair<int, int> position)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    auto listIt = chunkTicks_.find(position);
+    return listIt != chunkTicks_.end() ? GetTicks(listIt->second) : std::vector<ScheduledTick>();
+  }
+
+  std::vector<ScheduledTick> BlockTicks::DetachChunk(std::pair<int, int> position)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    auto listIt = chunkTicks_.find(position);
+    if (listIt == chunkTicks_.end())
+    {
+      return {};
+    }
+
+    // Wheel items of the list are skipped once they come due
+    std::vector<ScheduledTick> ticks = GetTicks(listIt->second);
+    scheduledNumber_ -= listIt->second.size();
+    chunkTicks_.erase(listIt);
+
+    return ticks;
+  }
+
+
+  std::vector<glm::ivec3> BlockTicks::Update(Map& map)
+  {
+    std::vector<TickItem> dueItems;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      wheel_.Advance(dueItems);
+      if (dueItems.empty())
+      {
+        return {};
+      }
+    }
+
+    // Due updates are handled a chunk at a time, chunks are looked up unlocked
+    std::sort(dueItems.begin(), dueItems.end(),
+      [](const TickItem& item1, const TickItem& item2) { return std::tie(item1.chunkPosition, item1.index) < std::tie(item2.chunkPosition, item2.index); });
+
+    std::vector<std::pair<size_t, std::shared_ptr<const Chunk>>> dueChunks;
+    for (size_t begin = 0, end = 0; begin < dueItems.size(); begin = end)
+    {
+      while (end < dueItems.size() && dueItems[end].chunkPosition == dueItems[begin].chunkPosition)
+      {
+        end++;
+      }
+      dueChunks.emplace_back(begin, map.FindChunk(dueItems[begin].chunkPosition));
+    }
+    dueChunks.emplace_back(dueItems.size(), nullptr);
+
+    std::shared_ptr<const BlockRegistry> registry = map.GetBlockRegistry();
+    std::vector<std::pair<std::pair<int, int>, std::vector<std::pair<glm::ivec3, Block>>>> changes;
+    std::vector<std::pair<int, int>> droppedChunks;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      std::uint64_t tick = wheel_.GetTick();
+      for (size_t i = 0; i + 1 < dueChunks.size(); i++)
+      {
+        auto [begin, chunk] = dueChunks[i];
+        size_t end = dueChunks[i + 1].first;
+        std::pair<int, int> position = dueItems[begin].chunkPosition;
+
+        // Lists detached meanwhile went away with their chunk
+        auto listIt = chunkTicks_.find(position);
+        if (listIt == chunkTicks_.end() || !chunk)
+        {
+          continue;
+        }
+
+        std::vector<std::pair<glm::ivec3, Block>> blocks;
+        bool isDropped = false;
+        for (size_t j = begin; j < end; j++)
+        {
+          std::uint32_t index = dueItems[j].index;
+          auto it = listIt->second.find(index);
+          if (it == listIt->second.end() || it->second != tick)
+          {
+            continue;
+          }
+          listIt->second.erase(it);
+          scheduledNumber_--;
+
+          // The block may have been replaced since it was scheduled
+          Block block = chunk->blocks[index];
+          if (registry && registry->IsTicking(block))
+          {
+            glm::ivec3 blockPosition = glm::ivec3(index % Chunk::Length, (index / Chunk::Length) % Chunk::Width, index / Chunk::LayerBlocksNumber);
+            blocks.emplace_back(blockPosition, registry->GetTickBlock(block));
+          }
+          else
+          {
+            isDropped = true;
+          }
+        }
+
+        if (listIt->second.empty())
+        {
+          chunkTicks_.erase(listIt);
+        }
+
+        if (!blocks.empty())
+        {
+          changes.emplace_back(position, std::move(blocks));
+        }
+        else if (isDropped)
+        {
+          droppedChunks.push_back(position);
+        }
+      }
+    }
+
+    // Published unlocked, new blocks that tick again are scheduled by the map
+    std::vector<glm::ivec3> changedCells;
+    for (const auto& [position, blocks] : changes)
+    {
+      map.SetBlocks(position, blocks);
+
+      glm::ivec3 chunkOrigin = glm::ivec3(position.first * (int)Chunk::Length, position.second * (int)Chunk::Width, 0);
+      for (const auto& [blockPosition, block] : blocks)
+      {
+        changedCells.push_back(chunkOrigin + blockPosition);
+      }
+    }
+
+    // Saved copies still list the dropped updates
+    for (const std::pair<int, int>& position : droppedChunks)
+    {
+      map.MarkChunkDirty(position);
+    }
+
+    return changedCells;
+  }
+
+
+  std::vector<ScheduledTick> BlockTicks::GetTicks(const std::map<std::uint32_t, std::uint64_t>& list) const
+  {
+    std::vector<ScheduledTick> ticks;
+    ticks.reserve(list.size());
+
+    std::uint64_t tick = wheel_.GetTick();
+    for (const auto& [index, dueTick] : list)
+    {
+      ticks.push_back(ScheduledTick{ index, dueTick > tick ? (std::uint32_t)std::min<std::uint64_t>(dueTick - tick, UINT32_MAX) : 0 });
+    }
+
+    return ticks;
+  }
+
+  void BlockTicks::Insert(std::pair<int, int> chunkPosition, std::uint32_t index, std::uint64_t dueTick)
+  {
+    auto [it, isInserted] = chunkTicks_[chunkPosition].emplace(index, dueTick);
+    if (isInserted)
+    {
+      scheduledNumber_++;
+    }
+    else if (it->second <= dueTick)
+    {
+      return;
+    }
+    else
+    {
+      it->second = dueTick;
+    }
+
+    wheel_.Schedule(dueTick, TickItem{ chunkPosition, index });
+  }
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk_codec.hpp"
+#include "containers/timing_wheel.hpp"
+
+
+namespace blocks
+{
+  class Map;
+
+  // Scheduled block updates for blocks that change on their own. Pending updates are kept per chunk, one due tick
+  // per cell, and are saved with the chunk. A timing wheel over the same entries finds what is due, so a tick costs
+  // as much as the updates due on it, however many are scheduled. Evicted chunks take their list along, updates
+  // of chunks that are not resident when due stay in their list until the chunk is attached again.
+  // Lock order: the map is never called while the ticks are locked.
+  class BlockTicks
+  {
+  public:
+    BlockTicks();
+    BlockTicks(const BlockTicks&) = delete;
+    BlockTicks(BlockTicks&& other) = delete;
+    BlockTicks& operator=(const BlockTicks&) = delete;
+    BlockTicks& operator=(BlockTicks&& other) = delete;
+
+    // An earlier pending update of the same cell wins
+    void Schedule(glm::ivec3 cell, std::uint32_t delay);
+    size_t GetScheduledNumber();
+
+    // Resumes updates of a chunk that became resident, saved ones are merged with those still kept in memory
+    void AttachChunk(std::pair<int, int> position, const std::vector<ScheduledTick>& ticks);
+    // Pending updates of the chunk with delays from the current tick, as they are stored with it
+    std::vector<ScheduledTick> GetChunkTicks(std::pair<int, int> position);
+    // Same as GetChunkTicks, but the updates leave memory, they are kept by the copy the chunk is reloaded from
+    std::vector<ScheduledTick> DetachChunk(std::pair<int, int> position);
+
+    // Turns blocks due this tick into their tick blocks, all changes of a chunk are published as one version.
+    // Returns cells that changed.
+    std::vector<glm::ivec3> Update(Map& map);
+
+  private:
+    struct TickItem
+    {
+      std::pair<int, int> chunkPosition;
+      std::uint32_t index;
+    };
+
+    std::vector<ScheduledTick> GetTicks(const std::map<std::uint32_t, std::uint64_t>& list) const;
+    void Insert(std::pair<int, int> chunkPosition, std::uint32_t index, std::uint64_t dueTick);
+
+    // Rescheduled cells leave their old wheel item behind, it is skipped when its tick does not match the list
+    TimingWheel<TickItem> wheel_;
+    std::map<std::pair<int, int>, std::map<std::uint32_t, std::uint64_t>> chunkTicks_;
+    size_t scheduledNumber_ = 0;
+    std::mutex mutex_;
+  };
+}
@@ -0,0 +1,171 @@
+#include "chunk_codec.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+
+namespace blocks
+{
+  std::vector<unsigned char> ChunkCodec::Encode(const Chunk& chunk, const std::vector<ScheduledTick>& ticks)
+  {
+    std::vector<Block> palette;
+    std::unordered_map<Block, std::uint32_t> paletteIndices;
+
+    std::vector<unsigned char> runs;
+    runs.reserve(1024);
+
+    size_t runStart = 0;
+    while (runStart < Chunk::BlocksNumber)
+    {
+      Block block = chunk.blocks[runStart];
+      size_t runEnd = runStart + 1;
+      while (runEnd < Chunk::BlocksNumber && chunk.blocks[runEnd] == block)
+      {
+        runEnd++;
+      }
+
+      auto it = paletteIndices.find(block);
+      if (it == paletteIndices.end())
+      {
+        it = paletteIndices.emplace(block, (std::uint32_t)palette.size()).first;
+        palette.push_back(block);
+      }
+
+      WriteVarint(runs, (std::uint32_t)(runEnd - runStart));
+      WriteVarint(runs, it->second);
+
+      runStart = runEnd;
+    }
+
+    if (!ticks.empty())
+    {
+      std::vector<ScheduledTick> sortedTicks = ticks;
+      std::sort(sortedTicks.begin(), sortedTicks.end(), [](const ScheduledTick& tick1, const ScheduledTick& tick2) { return tick1.index < tick2.index; });
+
+      WriteVarint(runs, (std::uint32_t)sortedTicks.size());
+      std::uint32_t previousIndex = 0;
+      for (const ScheduledTick& tick : sortedTicks)
+      {
+        WriteVarint(runs, tick.index - previousIndex);
+        WriteVarint(runs, tick.delay);
+        previousIndex = tick.index;
+      }
+    }
+
+    Header header;
+    header.magic = Magic;
+    header.version = Version;
+    header.flags = ticks.empty() ? 0 : TicksFlag;
+    header.paletteSize = (std::uint32_t)palette.size();
+
+    std::vector<unsigned char> result(sizeof(Header) + palette.size() * sizeof(Block) + runs.size());
+    unsigned char* output = &result[0];
+    memcpy(output, &header, sizeof(Header));
+    memcpy(output + sizeof(Header), &palette[0], palette.size() * sizeof(Block));
+    memcpy(output + sizeof(Header) + palette.size() * sizeof(Block), &runs[0], runs.size());
+
+    return result;
+  }
+
+  bool ChunkCodec::Decode(const unsigned char* data, size_t size, Chunk& chunk, std::vector<ScheduledTick>* ticks)
+  {
+    if (size < sizeof(Header))
+    {
+      return false;
+    }
+
+    Header header;
+    memcpy(&header, data, sizeof(Header));
+    if (header.magic != Magic || header.version == 0 || header.version > Version || header.paletteSize == 0 ||
+      header.paletteSize > Chunk::BlocksNumber || size < sizeof(Header) + header.paletteSize * sizeof(Block))
+    {
+      return false;
+    }
+
+    std::vector<Block> palette(header.paletteSize);
+    memcpy(&palette[0], data + sizeof(Header), header.paletteSize * sizeof(Block));
+
+    const unsigned char* input = data + sizeof(Header) + header.paletteSize * sizeof(Block);
+    const unsigned char* end = data + size;
+
+    size_t blockIndex = 0;
+    while (blockIndex < Chunk::BlocksNumber)
+    {
+      std::uint32_t runLength = 0;
+      std::uint32_t paletteIndex = 0;
+      if (!ReadVarint(input, end, runLength) || !ReadVarint(input, end, paletteIndex) ||
+        runLength == 0 || runLength > Chunk::BlocksNumber - blockIndex || paletteIndex >= header.paletteSize)
+      {
+        return false;
+      }
+
+      std::fill(chunk.blocks + blockIndex, chunk.blocks + blockIndex + runLength, palette[paletteIndex]);
+      blockIndex += runLength;
+    }
+
+    if (ticks)
+    {
+      ticks->clear();
+    }
+    if (header.version >= 2 && (header.flags & TicksFlag) != 0)
+    {
+      std::uint32_t ticksNumber = 0;
+      if (!ReadVarint(input, end, ticksNumber) || ticksNumber > Chunk::BlocksNumber)
+      {
+        return false;
+      }
+
+      std::uint32_t index = 0;
+      for (std::uint32_t i = 0; i < ticksNumber; i++)
+      {
+        std::uint32_t indexStep = 0;
+        std::uint32_t delay = 0;
+        if (!ReadVarint(input, end, indexStep) || !ReadVarint(input, end, delay) || indexStep >= Chunk::BlocksNumber - index)
+        {
+          return false;
+        }
+
+        index += indexStep;
+        if (ticks)
+        {
+          ticks->push_back(ScheduledTick{ index, delay });
+        }
+      }
+    }
+
+    return input == end;
+  }
+
+
+  void ChunkCodec::WriteVarint(std::vector<unsigned char>& data, std::uint32_t value)
+  {
+    while (value >= 0x80)
+    {
+      data.push_back((unsigned char)(value | 0x80));
+      value >>= 7;
+    }
+    data.push_back((unsigned char)value);
+  }
+
+  bool ChunkCodec::ReadVarint(const unsigned char*& data, const unsigned char* end, std::uint32_t& value)
+  {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+      if (data == end)
+      {
+        return false;
+      }
+
+      unsigned char byte = *data++;
+      value |= (std::uint32_t)(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0)
+      {
+        return true;
+      }
+    }
+
+    return false;
+  }
+}
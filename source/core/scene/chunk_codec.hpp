@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "chunk.hpp"
+
+
+namespace blocks
+{
+  // Block update still pending when the chunk was stored, the delay is kept relative to the save
+  struct ScheduledTick
+  {
+    std::uint32_t index;
+    std::uint32_t delay;
+  };
+
+  // Serialized chunk: versioned header, palette of distinct blocks, then runs of
+  // (length, palette index) as varints over blocks in memory order, so whole uniform layers collapse into one run.
+  // Since version 2 pending block ticks may follow as varint (index step, delay) pairs sorted by block index.
+  class ChunkCodec
+  {
+  public:
+    static const std::uint32_t Magic = 0x4B484342; // "BCHK"
+    static const std::uint16_t Version = 2;
+
+    static std::vector<unsigned char> Encode(const Chunk& chunk, const std::vector<ScheduledTick>& ticks = {});
+    // Chunks of version 1 decode without ticks
+    static bool Decode(const unsigned char* data, size_t size, Chunk& chunk, std::vector<ScheduledTick>* ticks = nullptr);
+
+  private:
+    static const std::uint16_t TicksFlag = 1 << 0;
+
+    struct Header
+    {
+      std::uint32_t magic;
+      std::uint16_t version;
+      std::uint16_t flags;
+      std::uint32_t paletteSize;
+    };
+
+    static void WriteVarint(std::vector<unsigned char>& data, std::uint32_t value);
+    static bool ReadVarint(const unsigned char*& data, const unsigned char* end, std::uint32_t& value);
+  };
+}
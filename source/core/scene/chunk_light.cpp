@@ -0,0 +1,54 @@
+#include "chunk_light.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+
+namespace blocks
+{
+  ChunkLight::ChunkLight(std::uint8_t light)
+  {
+    uniformLights_.fill(light);
+  }
+
+
+  void ChunkLight::Set(glm::ivec3 position, std::uint8_t light)
+  {
+    int section = position.z / LightSection::Height;
+    if (!sections_[section])
+    {
+      if (uniformLights_[section] == light)
+      {
+        return;
+      }
+
+      sections_[section] = std::make_shared<LightSection>();
+      memset(sections_[section]->cells, uniformLights_[section], LightSection::CellsNumber);
+    }
+    else if (sections_[section].use_count() > 1)
+    {
+      // Shared with a published copy
+      sections_[section] = std::make_shared<LightSection>(*sections_[section]);
+    }
+
+    sections_[section]->cells[GetIndex(position)] = light;
+  }
+
+  void ChunkLight::Compact()
+  {
+    for (int section = 0; section < SectionsNumber; section++)
+    {
+      if (!sections_[section])
+      {
+        continue;
+      }
+
+      const std::uint8_t* cells = sections_[section]->cells;
+      if (std::all_of(cells, cells + LightSection::CellsNumber, [cells](std::uint8_t light) { return light == cells[0]; }))
+      {
+        uniformLights_[section] = cells[0];
+        sections_[section] = nullptr;
+      }
+    }
+  }
+}
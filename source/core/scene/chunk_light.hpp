@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+
+
+namespace blocks
+{
+  struct LightSection
+  {
+    static const int Height = 16;
+    static const size_t CellsNumber = Chunk::LayerBlocksNumber * Height;
+
+    std::uint8_t cells[CellsNumber];
+  };
+
+  // Light levels of a chunk, sky light in the high nibble and block light in the low one.
+  // Sections holding a single value (open sky, solid rock) keep no storage, stored sections are shared
+  // between copies and copied on the first write, so a published light is never changed.
+  class ChunkLight
+  {
+  public:
+    static const int SectionsNumber = Chunk::Height / LightSection::Height;
+    static constexpr std::uint8_t MaxLevel = 15;
+
+    ChunkLight(std::uint8_t light = 0);
+
+    std::uint8_t Get(glm::ivec3 position) const
+    {
+      int section = position.z / LightSection::Height;
+      if (!sections_[section])
+      {
+        return uniformLights_[section];
+      }
+
+      return sections_[section]->cells[GetIndex(position)];
+    }
+
+    void Set(glm::ivec3 position, std::uint8_t light);
+    // Releases storage of sections that ended up holding a single value
+    void Compact();
+
+    static std::uint8_t GetSkyLevel(std::uint8_t light)
+    {
+      return light >> 4;
+    }
+
+    static std::uint8_t GetBlockLevel(std::uint8_t light)
+    {
+      return light & 0x0F;
+    }
+
+    static std::uint8_t Pack(std::uint8_t skyLevel, std::uint8_t blockLevel)
+    {
+      return (std::uint8_t)((skyLevel << 4) | blockLevel);
+    }
+
+  private:
+    static int GetIndex(glm::ivec3 position)
+    {
+      return position.x + position.y * Chunk::Width + (position.z % LightSection::Height) * Chunk::LayerBlocksNumber;
+    }
+
+    std::array<std::shared_ptr<LightSection>, SectionsNumber> sections_;
+    std::array<std::uint8_t, SectionsNumber> uniformLights_;
+  };
+
+
+  // Light of a chunk and its eight neighbours as seen by the mesher, cells just outside the chunk are readable
+  struct ChunkLightView
+  {
+    std::shared_ptr<const ChunkLight> lights[3][3];
+
+    std::uint8_t Get(glm::ivec3 position) const
+    {
+      if (position.z >= (int)Chunk::Height)
+      {
+        return ChunkLight::Pack(ChunkLight::MaxLevel, 0);
+      }
+      if (position.z < 0)
+      {
+        return 0;
+      }
+
+      int neighbourX = position.x < 0 ? 0 : (position.x >= (int)Chunk::Length ? 2 : 1);
+      int neighbourY = position.y < 0 ? 0 : (position.y >= (int)Chunk::Width ? 2 : 1);
+      const std::shared_ptr<const ChunkLight>& light = lights[neighbourX][neighbourY];
+      if (!light)
+      {
+        // Neighbour is not lit yet, borrow the closest cell of the chunk itself
+        glm::ivec3 clamped = glm::ivec3(glm::clamp(position.x, 0, (int)Chunk::Length - 1), glm::clamp(position.y, 0, (int)Chunk::Width - 1), position.z);
+        return lights[1][1] ? lights[1][1]->Get(clamped) : ChunkLight::Pack(ChunkLight::MaxLevel, 0);
+      }
+
+      return light->Get(glm::ivec3(position.x - (neighbourX - 1) * (int)Chunk::Length, position.y - (neighbourY - 1) * (int)Chunk::Width, position.z));
+    }
+  };
+}
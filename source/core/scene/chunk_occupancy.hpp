@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+
+
+namespace blocks
+{
+  // "Any solid" summary of a chunk in 4x4x4 cells. Each 16x16x16 region owns exactly one word of cell bits,
+  // so a zero word marks an empty region and the coarse level needs no storage of its own.
+  struct ChunkOccupancy
+  {
+    static const int CellSize = 4;
+    static const int RegionSize = 16;
+    static const int RegionsNumber = Chunk::Height / RegionSize;
+
+    std::uint64_t regions[RegionsNumber] = {};
+
+    bool IsRegionEmpty(int z) const
+    {
+      return regions[z / RegionSize] == 0;
+    }
+
+    bool IsCellEmpty(glm::ivec3 blockPosition) const
+    {
+      int bit = GetCellIndex(blockPosition) % 64;
+      return (regions[blockPosition.z / RegionSize] & (1ull << bit)) == 0;
+    }
+
+    template <typename SolidPredicate>
+    static ChunkOccupancy Build(const Chunk& chunk, SolidPredicate isSolid)
+    {
+      ChunkOccupancy occupancy;
+      for (int z = 0; z < (int)Chunk::Height; z++)
+      {
+        for (int y = 0; y < (int)Chunk::Width; y++)
+        {
+          for (int x = 0; x < (int)Chunk::Length; x++)
+          {
+            if (isSolid(chunk.blocks[x + y * Chunk::Width + z * Chunk::LayerBlocksNumber]))
+            {
+              occupancy.SetCell(glm::ivec3(x, y, z), true);
+            }
+          }
+        }
+      }
+
+      return occupancy;
+    }
+
+    // Only the cell holding the edited block is scanned again
+    template <typename SolidPredicate>
+    void Update(const Chunk& chunk, glm::ivec3 blockPosition, SolidPredicate isSolid)
+    {
+      glm::ivec3 cellLow = (blockPosition / CellSize) * CellSize;
+
+      bool isSolidCell = false;
+      for (int z = cellLow.z; z < cellLow.z + CellSize && !isSolidCell; z++)
+      {
+        for (int y = cellLow.y; y < cellLow.y + CellSize && !isSolidCell; y++)
+        {
+          for (int x = cellLow.x; x < cellLow.x + CellSize && !isSolidCell; x++)
+          {
+            isSolidCell = isSolid(chunk.blocks[x + y * Chunk::Width + z * Chunk::LayerBlocksNumber]);
+          }
+        }
+      }
+
+      SetCell(blockPosition, isSolidCell);
+    }
+
+  private:
+    static int GetCellIndex(glm::ivec3 blockPosition)
+    {
+      return blockPosition.x / CellSize + (blockPosition.y / CellSize) * 4 + (blockPosition.z / CellSize) * 16;
+    }
+
+    void SetCell(glm::ivec3 blockPosition, bool isSolid)
+    {
+      std::uint64_t mask = 1ull << (GetCellIndex(blockPosition) % 64);
+      std::uint64_t& region = regions[blockPosition.z / RegionSize];
+      region = isSolid ? (region | mask) : (region & ~mask);
+    }
+  };
+}
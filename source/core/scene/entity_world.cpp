@@ -0,0 +1,322 @@
+#include "entity_world.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+#include "geometry/collisions_api.hpp"
+
+
+namespace blocks
+{
+  namespace
+  {
+    const float Gravity = 20.0f;
+    const float GroundFriction = 8.0f;
+    const float SeparationSpeed = 4.0f;
+    // Entities falling out of the world are removed
+    const float MinHeight = -64.0f;
+    // Largest half extent of any entity type, bounds the broadphase query
+    const float MaxHalfSize = 0.45f;
+  }
+
+
+  EntityWorld::EntityWorld() : spatialHash_(1.0f)
+  {
+
+  }
+
+
+  EntityId EntityWorld::Spawn(EntityType type, glm::vec3 position, glm::vec3 velocity)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    EntityId id;
+    if (!freeIds_.empty())
+    {
+      id = freeIds_.back();
+      freeIds_.pop_back();
+    }
+    else
+    {
+      id = (EntityId)indices_.size();
+      indices_.push_back(InvalidIndex);
+    }
+
+    indices_[id] = (std::uint32_t)ids_.size();
+    positionX_.push_back(position.x);
+    positionY_.push_back(position.y);
+    positionZ_.push_back(position.z);
+    velocityX_.push_back(velocity.x);
+    velocityY_.push_back(velocity.y);
+    velocityZ_.push_back(velocity.z);
+    types_.push_back(type);
+    ids_.push_back(id);
+    isHashValid_ = false;
+
+    return id;
+  }
+
+  void EntityWorld::Despawn(EntityId id)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (id < indices_.size() && indices_[id] != InvalidIndex)
+    {
+      RemoveAt(indices_[id]);
+    }
+  }
+
+  size_t EntityWorld::GetEntitiesNumber()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return ids_.size();
+  }
+
+
+  void EntityWorld::Update(float delta, Map& map)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    Integrate(delta, map);
+    Separate(delta);
+  }
+
+  void EntityWorld::QueryBox(const AABB& bounds, std::vector<EntityId>& result)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (!isHashValid_)
+    {
+      spatialHash_.Build(positionX_.data(), positionY_.data(), positionZ_.data(), ids_.size());
+      isHashValid_ = true;
+    }
+
+    candidates_.clear();
+    candidateBounds_.Clear();
+    AABB queryBounds(bounds.low - MaxHalfSize, bounds.high + MaxHalfSize);
+    spatialHash_.Query(queryBounds, [this](std::uint32_t index) { AddCandidate(index); });
+
+    if (TestCandidates(bounds) == 0)
+    {
+      return;
+    }
+    for (size_t k = 0; k < candidates_.size(); k++)
+    {
+      if (candidateHits_[k])
+      {
+        result.push_back(ids_[candidates_[k]]);
+      }
+    }
+  }
+
+
+  AABB EntityWorld::GetBounds(EntityType type)
+  {
+    switch (type)
+    {
+    case EntityType::Mob:
+      return AABB(glm::vec3(-0.3f, -0.3f, -0.45f), glm::vec3(0.3f, 0.3f, 0.45f));
+    case EntityType::Item:
+      return AABB(glm::vec3(-0.125f), glm::vec3(0.125f));
+    case EntityType::Projectile:
+    default:
+      return AABB(glm::vec3(-0.05f), glm::vec3(0.05f));
+    }
+  }
+
+
+  void EntityWorld::Integrate(float delta, Map& map)
+  {
+    // MoveBox never loads chunks and treats missing ones as solid, entities next to them are frozen instead
+    // of stopping at walls that are not there. Neighbourhood residency is looked up once per chunk and tick.
+    std::map<std::pair<int, int>, bool> activeChunks;
+    auto isActive = [&](glm::vec3 position)
+    {
+      std::pair<int, int> chunkPosition = std::make_pair((int)std::floor(position.x / Chunk::Length), (int)std::floor(position.y / Chunk::Width));
+      auto it = activeChunks.find(chunkPosition);
+      if (it != activeChunks.end())
+      {
+        return it->second;
+      }
+
+      bool isResident = true;
+      for (int x = -1; x <= 1 && isResident; x++)
+      {
+        for (int y = -1; y <= 1 && isResident; y++)
+        {
+          isResident = map.FindChunk(std::make_pair(chunkPosition.first + x, chunkPosition.second + y)) != nullptr;
+        }
+      }
+      activeChunks.emplace(chunkPosition, isResident);
+
+      return isResident;
+    };
+
+    std::vector<std::uint32_t> fallenEntities;
+    for (std::uint32_t i = 0; i < (std::uint32_t)ids_.size(); i++)
+    {
+      glm::vec3 position = glm::vec3(positionX_[i], positionY_[i], positionZ_[i]);
+      if (position.z < MinHeight)
+      {
+        fallenEntities.push_back(i);
+        continue;
+      }
+
+      if (!isActive(position))
+      {
+        continue;
+      }
+
+      velocityZ_[i] -= Gravity * delta;
+      glm::vec3 velocity = glm::vec3(velocityX_[i], velocityY_[i], velocityZ_[i]);
+
+      glm::bvec3 blockedAxes;
+      position = map.MoveBox(GetBounds(types_[i]), position, velocity * delta, &blockedAxes);
+
+      if (types_[i] == EntityType::Projectile && glm::any(blockedAxes))
+      {
+        // Projectiles stick where they hit
+        velocity = glm::vec3(0.0f);
+      }
+      else
+      {
+        bool isGrounded = blockedAxes.z && velocity.z < 0.0f;
+        for (int axis = 0; axis < 3; axis++)
+        {
+          if (blockedAxes[axis])
+          {
+            velocity[axis] = 0.0f;
+          }
+        }
+
+        if (isGrounded)
+        {
+          float friction = std::max(1.0f - GroundFriction * delta, 0.0f);
+          velocity.x *= friction;
+          velocity.y *= friction;
+        }
+      }
+
+      positionX_[i] = position.x;
+      positionY_[i] = position.y;
+      positionZ_[i] = position.z;
+      velocityX_[i] = velocity.x;
+      velocityY_[i] = velocity.y;
+      velocityZ_[i] = velocity.z;
+    }
+
+    // Removal moves the last entity into the hole, so go from the back
+    for (size_t i = fallenEntities.size(); i-- > 0;)
+    {
+      RemoveAt(fallenEntities[i]);
+    }
+    isHashValid_ = false;
+  }
+
+  void EntityWorld::Separate(float delta)
+  {
+    spatialHash_.Build(positionX_.data(), positionY_.data(), positionZ_.data(), ids_.size());
+    isHashValid_ = true;
+
+    // Overlapping entities are pushed apart horizontally, each pair once
+    float impulse = SeparationSpeed * delta;
+    for (std::uint32_t i = 0; i < (std::uint32_t)ids_.size(); i++)
+    {
+      if (types_[i] == EntityType::Projectile)
+      {
+        continue;
+      }
+
+      glm::vec3 position = glm::vec3(positionX_[i], positionY_[i], positionZ_[i]);
+      AABB bounds = GetBounds(types_[i]);
+      AABB worldBounds(bounds.low + position, bounds.high + position);
+
+      candidates_.clear();
+      candidateBounds_.Clear();
+      spatialHash_.Query(AABB(worldBounds.low - MaxHalfSize, worldBounds.high + MaxHalfSize),
+        [&](std::uint32_t j)
+        {
+          if (j > i && types_[j] != EntityType::Projectile)
+          {
+            AddCandidate(j);
+          }
+        }
+      );
+
+      if (TestCandidates(worldBounds) == 0)
+      {
+        continue;
+      }
+      for (size_t k = 0; k < candidates_.size(); k++)
+      {
+        if (candidateHits_[k])
+        {
+          std::uint32_t j = candidates_[k];
+          glm::vec3 otherPosition = glm::vec3(positionX_[j], positionY_[j], positionZ_[j]);
+          glm::vec2 direction = glm::vec2(position.x - otherPosition.x, position.y - otherPosition.y);
+          float length = glm::length(direction);
+          // Stacked exactly on top of each other, pick a direction that differs per pair
+          direction = length > 1e-4f ? direction / length : glm::vec2(((i ^ j) & 1) ? 1.0f : -1.0f, ((i ^ j) & 2) ? 1.0f : -1.0f) * 0.70710678f;
+
+          velocityX_[i] += direction.x * impulse;
+          velocityY_[i] += direction.y * impulse;
+          velocityX_[j] -= direction.x * impulse;
+          velocityY_[j] -= direction.y * impulse;
+        }
+      }
+    }
+  }
+
+  void EntityWorld::AddCandidate(std::uint32_t index)
+  {
+    glm::vec3 position = glm::vec3(positionX_[index], positionY_[index], positionZ_[index]);
+    AABB bounds = GetBounds(types_[index]);
+
+    candidates_.push_back(index);
+    candidateBounds_.Add(AABB(bounds.low + position, bounds.high + position));
+  }
+
+  size_t EntityWorld::TestCandidates(const AABB& bounds)
+  {
+    if (candidateHitsCapacity_ < candidates_.size())
+    {
+      candidateHitsCapacity_ = std::max(candidates_.size(), candidateHitsCapacity_ * 2);
+      candidateHits_ = std::make_unique<bool[]>(candidateHitsCapacity_);
+    }
+
+    return CheckCollisions(bounds, candidateBounds_, candidateHits_.get());
+  }
+
+  void EntityWorld::RemoveAt(std::uint32_t index)
+  {
+    std::uint32_t last = (std::uint32_t)ids_.size() - 1;
+
+    indices_[ids_[index]] = InvalidIndex;
+    freeIds_.push_back(ids_[index]);
+
+    if (index != last)
+    {
+      positionX_[index] = positionX_[last];
+      positionY_[index] = positionY_[last];
+      positionZ_[index] = positionZ_[last];
+      velocityX_[index] = velocityX_[last];
+      velocityY_[index] = velocityY_[last];
+      velocityZ_[index] = velocityZ_[last];
+      types_[index] = types_[last];
+      ids_[index] = ids_[last];
+      indices_[ids_[index]] = index;
+    }
+
+    positionX_.pop_back();
+    positionY_.pop_back();
+    positionZ_.pop_back();
+    velocityX_.pop_back();
+    velocityY_.pop_back();
+    velocityZ_.pop_back();
+    types_.pop_back();
+    ids_.pop_back();
+    isHashValid_ = false;
+  }
+}
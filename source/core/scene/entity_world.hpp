@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "map.hpp"
+#include "spatial_hash.hpp"
+#include "geometry/aabb.hpp"
+#include "geometry/aabb_batch.hpp"
+#include "memory/aligned_allocator.hpp"
+
+
+namespace blocks
+{
+  typedef std::uint32_t EntityId;
+
+  enum class EntityType : std::uint8_t
+  {
+    Mob,
+    Item,
+    Projectile
+  };
+
+  // Dynamic objects kept as structure of arrays components, removal swaps the last entity into the hole.
+  // Entities only move while their chunk neighbourhood is resident, so they never force chunk generation.
+  class EntityWorld
+  {
+  public:
+    static constexpr EntityId InvalidId = 0xFFFFFFFF;
+
+    EntityWorld();
+    EntityWorld(const EntityWorld&) = delete;
+    EntityWorld(EntityWorld&& other) = delete;
+    EntityWorld& operator=(const EntityWorld&) = delete;
+    EntityWorld& operator=(EntityWorld&& other) = delete;
+
+    EntityId Spawn(EntityType type, glm::vec3 position, glm::vec3 velocity = glm::vec3(0.0f));
+    void Despawn(EntityId id);
+    size_t GetEntitiesNumber();
+
+    void Update(float delta, Map& map);
+    // Appends entities whose bounds intersect the box
+    void QueryBox(const AABB& bounds, std::vector<EntityId>& result);
+
+    static AABB GetBounds(EntityType type);
+
+  private:
+    static constexpr std::uint32_t InvalidIndex = 0xFFFFFFFF;
+
+    void Integrate(float delta, Map& map);
+    void Separate(float delta);
+    void RemoveAt(std::uint32_t index);
+    // Narrow phase, broadphase candidates are collected and tested against the box in one batch
+    void AddCandidate(std::uint32_t index);
+    size_t TestCandidates(const AABB& bounds);
+
+    std::vector<float, AlignedAllocator<float>> positionX_;
+    std::vector<float, AlignedAllocator<float>> positionY_;
+    std::vector<float, AlignedAllocator<float>> positionZ_;
+    std::vector<float, AlignedAllocator<float>> velocityX_;
+    std::vector<float, AlignedAllocator<float>> velocityY_;
+    std::vector<float, AlignedAllocator<float>> velocityZ_;
+    std::vector<EntityType> types_;
+    std::vector<EntityId> ids_;
+
+    // Id to dense index, stays valid while entities are swapped around
+    std::vector<std::uint32_t> indices_;
+    std::vector<EntityId> freeIds_;
+
+    SpatialHash spatialHash_;
+    std::vector<std::uint32_t> candidates_;
+    AABBBatch candidateBounds_;
+    std::unique_ptr<bool[]> candidateHits_;
+    size_t candidateHitsCapacity_ = 0;
+    bool isHashValid_ = false;
+    std::mutex mutex_;
+  };
+}
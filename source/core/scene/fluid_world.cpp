@@ -0,0 +1,291 @@
+#include "fluid_world.hpp"
+
+#include <algorithm>
+
+#include "math_utils.hpp"
+
+
+namespace blocks
+{
+  namespace
+  {
+    const glm::ivec3 Neighbours[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    const glm::ivec3 SideNeighbours[4] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 } };
+    const glm::ivec3 Up = glm::ivec3(0, 0, 1);
+  }
+
+
+  FluidWorld::FluidWorld()
+  {
+
+  }
+
+
+  void FluidWorld::Activate(glm::ivec3 cell)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    ScheduleAround(cell, tick_ + 1);
+  }
+
+  size_t FluidWorld::GetActiveCellsNumber()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return scheduledNumber_;
+  }
+
+
+  std::vector<std::pair<int, int>> FluidWorld::Update(Map& map)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    tick_++;
+    auto bucketIt = scheduledCells_.find(tick_);
+    if (bucketIt == scheduledCells_.end())
+    {
+      return {};
+    }
+
+    ChunkCells cells = std::move(bucketIt->second);
+    scheduledCells_.erase(bucketIt);
+
+    std::shared_ptr<const BlockRegistry> registry = map.GetBlockRegistry();
+    ChunkChanges changes;
+    for (auto& [position, indices] : cells)
+    {
+      scheduledNumber_ -= indices.size();
+      if (!registry)
+      {
+        continue;
+      }
+
+      // A cell woken by several neighbours steps once
+      std::sort(indices.begin(), indices.end());
+      indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+
+      glm::ivec3 chunkOrigin = glm::ivec3(position.first * (int)Chunk::Length, position.second * (int)Chunk::Width, 0);
+      for (std::uint32_t index : indices)
+      {
+        glm::ivec3 cell = chunkOrigin + glm::ivec3(index % Chunk::Length, (index / Chunk::Length) % Chunk::Width, index / Chunk::LayerBlocksNumber);
+
+        Block block;
+        if (!GetBlock(map, cell, block))
+        {
+          Park(position, position, index);
+          continue;
+        }
+        if (!registry->IsFluid(block))
+        {
+          continue;
+        }
+
+        StepCell(map, *registry, cell, block, changes);
+
+        // Flow stops at chunks that are not resident and goes on once they are back
+        for (const glm::ivec3& neighbour : Neighbours)
+        {
+          std::pair<int, int> neighbourPosition = GetChunkPosition(cell + neighbour);
+          auto it = tickChunks_.find(neighbourPosition);
+          if (neighbourPosition != position && it != tickChunks_.end() && !it->second)
+          {
+            Park(neighbourPosition, position, index);
+          }
+        }
+      }
+    }
+
+    std::vector<std::pair<int, int>> changedChunks;
+    changedChunks.reserve(changes.size());
+    for (const auto& [position, chunkChanges] : changes)
+    {
+      const Chunk& chunk = *tickChunks_[position];
+      glm::ivec3 chunkOrigin = glm::ivec3(position.first * (int)Chunk::Length, position.second * (int)Chunk::Width, 0);
+
+      std::vector<std::pair<glm::ivec3, Block>> blocks;
+      blocks.reserve(chunkChanges.size());
+      for (const auto& [index, block] : chunkChanges)
+      {
+        glm::ivec3 blockPosition = glm::ivec3(index % Chunk::Length, (index / Chunk::Length) % Chunk::Width, index / Chunk::LayerBlocksNumber);
+        blocks.emplace_back(blockPosition, block);
+
+        // Surroundings react at the pace of the fluid that came or left
+        Block fluid = registry->IsFluid(block) ? block : chunk.blocks[index];
+        ScheduleAround(chunkOrigin + blockPosition, tick_ + registry->GetFluidDelay(fluid));
+      }
+
+      map.SetBlocks(position, blocks);
+      changedChunks.push_back(position);
+    }
+
+    tickChunks_.clear();
+    return changedChunks;
+  }
+
+
+  void FluidWorld::AttachChunk(std::pair<int, int> position)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    auto parkedIt = parkedCells_.find(position);
+    if (parkedIt == parkedCells_.end())
+    {
+      return;
+    }
+
+    ChunkCells& bucket = scheduledCells_[tick_ + 1];
+    for (const auto& [cellsPosition, indices] : parkedIt->second)
+    {
+      std::vector<std::uint32_t>& scheduledIndices = bucket[cellsPosition];
+      scheduledIndices.insert(scheduledIndices.end(), indices.begin(), indices.end());
+      scheduledNumber_ += indices.size();
+    }
+    parkedCells_.erase(parkedIt);
+  }
+
+
+  void FluidWorld::Schedule(glm::ivec3 cell, std::uint64_t tick)
+  {
+    if (cell.z < 0 || cell.z >= (int)Chunk::Height)
+    {
+      return;
+    }
+
+    scheduledCells_[tick][GetChunkPosition(cell)].push_back(GetIndex(cell));
+    scheduledNumber_++;
+  }
+
+  void FluidWorld::ScheduleAround(glm::ivec3 cell, std::uint64_t tick)
+  {
+    Schedule(cell, tick);
+    for (const glm::ivec3& neighbour : Neighbours)
+    {
+      Schedule(cell + neighbour, tick);
+    }
+  }
+
+
+  void FluidWorld::Park(std::pair<int, int> missingPosition, std::pair<int, int> position, std::uint32_t index)
+  {
+    std::vector<std::uint32_t>& indices = parkedCells_[missingPosition][position];
+    if (indices.empty() || indices.back() != index)
+    {
+      indices.push_back(index);
+    }
+  }
+
+
+  void FluidWorld::StepCell(Map& map, const BlockRegistry& registry, glm::ivec3 cell, Block block, ChunkChanges& changes)
+  {
+    Block type = GetBlockType(block);
+    std::uint32_t distance = GetBlockState(block);
+    std::uint32_t spread = registry.GetFluidSpread(block);
+
+    // Flowing cells live off the same fluid above them or a side neighbour closer to the source
+    if (distance != 0)
+    {
+      std::uint32_t supportedDistance = spread + 1;
+
+      Block neighbour;
+      if (GetBlock(map, cell + Up, neighbour) && GetBlockType(neighbour) == type)
+      {
+        supportedDistance = 1;
+      }
+      else
+      {
+        for (const glm::ivec3& side : SideNeighbours)
+        {
+          if (GetBlock(map, cell + side, neighbour) && GetBlockType(neighbour) == type)
+          {
+            supportedDistance = std::min(supportedDistance, GetBlockState(neighbour) + 1);
+          }
+        }
+      }
+
+      if (supportedDistance > spread)
+      {
+        SetChange(cell, 0, changes);
+        return;
+      }
+      if (supportedDistance != distance)
+      {
+        // Spreading goes on once the new distance is settled
+        SetChange(cell, MakeBlock(type, supportedDistance), changes);
+        return;
+      }
+    }
+
+    // Falling comes before spreading sideways
+    Block below;
+    if (cell.z > 0 && GetBlock(map, cell - Up, below))
+    {
+      if (below == 0)
+      {
+        SetChange(cell - Up, MakeBlock(type, 1), changes);
+        return;
+      }
+      if (GetBlockType(below) == type)
+      {
+        return;
+      }
+    }
+
+    if (distance >= spread)
+    {
+      return;
+    }
+
+    for (const glm::ivec3& side : SideNeighbours)
+    {
+      Block neighbour;
+      if (GetBlock(map, cell + side, neighbour) && neighbour == 0)
+      {
+        SetChange(cell + side, MakeBlock(type, distance + 1), changes);
+      }
+    }
+  }
+
+  void FluidWorld::SetChange(glm::ivec3 cell, Block block, ChunkChanges& changes)
+  {
+    auto [it, isInserted] = changes[GetChunkPosition(cell)].emplace(GetIndex(cell), block);
+    if (!isInserted && GetBlockType(it->second) == GetBlockType(block) && GetBlockState(block) < GetBlockState(it->second))
+    {
+      it->second = block;
+    }
+  }
+
+  bool FluidWorld::GetBlock(Map& map, glm::ivec3 cell, Block& block)
+  {
+    if (cell.z < 0 || cell.z >= (int)Chunk::Height)
+    {
+      return false;
+    }
+
+    std::pair<int, int> position = GetChunkPosition(cell);
+    auto it = tickChunks_.find(position);
+    if (it == tickChunks_.end())
+    {
+      it = tickChunks_.emplace(position, map.FindChunk(position)).first;
+    }
+    if (!it->second)
+    {
+      return false;
+    }
+
+    block = it->second->blocks[GetIndex(cell)];
+    return true;
+  }
+
+
+  std::pair<int, int> FluidWorld::GetChunkPosition(glm::ivec3 cell)
+  {
+    return std::make_pair(floorDivide(cell.x, Chunk::Length), floorDivide(cell.y, Chunk::Width));
+  }
+
+  std::uint32_t FluidWorld::GetIndex(glm::ivec3 cell)
+  {
+    int x = cell.x - floorDivide(cell.x, Chunk::Length) * (int)Chunk::Length;
+    int y = cell.y - floorDivide(cell.y, Chunk::Width) * (int)Chunk::Width;
+    return (std::uint32_t)(x + y * Chunk::Width + cell.z * Chunk::LayerBlocksNumber);
+  }
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "map.hpp"
+
+
+namespace blocks
+{
+  // Water and lava flowing as a cellular automaton, a fluid block keeps its distance from the source in the block state.
+  // Only cells next to a change are scheduled, bucketed by due tick and chunk,
+  // so a tick costs as much as the fluid in motion and nothing for still or unloaded areas.
+  class FluidWorld
+  {
+  public:
+    FluidWorld();
+    FluidWorld(const FluidWorld&) = delete;
+    FluidWorld(FluidWorld&& other) = delete;
+    FluidWorld& operator=(const FluidWorld&) = delete;
+    FluidWorld& operator=(FluidWorld&& other) = delete;
+
+    // Wakes the cell and its neighbours on the next tick, used for edits made outside the simulation
+    void Activate(glm::ivec3 cell);
+    size_t GetActiveCellsNumber();
+
+    // Steps cells due this tick, all changes of a chunk are published as one version.
+    // Returns chunks that changed, cells of chunks that are not resident wait until the chunk is attached.
+    std::vector<std::pair<int, int>> Update(Map& map);
+    // Wakes cells that waited for the chunk, due in it or next to its border, on the next tick
+    void AttachChunk(std::pair<int, int> position);
+
+  private:
+    typedef std::map<std::pair<int, int>, std::vector<std::uint32_t>> ChunkCells;
+    typedef std::map<std::pair<int, int>, std::map<std::uint32_t, Block>> ChunkChanges;
+
+    void Schedule(glm::ivec3 cell, std::uint64_t tick);
+    void ScheduleAround(glm::ivec3 cell, std::uint64_t tick);
+    // Keeps the cell for the chunk it could not read
+    void Park(std::pair<int, int> missingPosition, std::pair<int, int> position, std::uint32_t index);
+
+    void StepCell(Map& map, const BlockRegistry& registry, glm::ivec3 cell, Block block, ChunkChanges& changes);
+    // Changes are computed from the blocks at the start of the tick, the closest flow wins a contested cell
+    void SetChange(glm::ivec3 cell, Block block, ChunkChanges& changes);
+    // False for cells of chunks that are not resident
+    bool GetBlock(Map& map, glm::ivec3 cell, Block& block);
+
+    static std::pair<int, int> GetChunkPosition(glm::ivec3 cell);
+    static std::uint32_t GetIndex(glm::ivec3 cell);
+
+    std::map<std::uint64_t, ChunkCells> scheduledCells_;
+    // Cells waiting for a chunk that was not resident, by that chunk
+    std::map<std::pair<int, int>, ChunkCells> parkedCells_;
+    size_t scheduledNumber_ = 0;
+    std::uint64_t tick_ = 0;
+    // Chunks read during the current tick
+    std::map<std::pair<int, int>, std::shared_ptr<const Chunk>> tickChunks_;
+    std::mutex mutex_;
+  };
+}
@@ -0,0 +1,375 @@
+#include "light_engine.hpp"
+
+#include "math_utils.hpp"
+
+
+namespace blocks
+{
+  namespace
+  {
+    const glm::ivec3 Neighbours[6] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+
+    size_t GetBlockIndex(glm::ivec3 localCell)
+    {
+      return localCell.x + localCell.y * Chunk::Width + localCell.z * Chunk::LayerBlocksNumber;
+    }
+  }
+
+
+  LightEngine::LightEngine(const BlockRegistry* registry, ChunkSource source) : registry_(registry), source_(source)
+  {
+
+  }
+
+
+  std::shared_ptr<ChunkLight> LightEngine::ComputeChunk(const Chunk& chunk, const BlockRegistry* registry)
+  {
+    std::shared_ptr<ChunkLight> light = std::make_shared<ChunkLight>(ChunkLight::Pack(ChunkLight::MaxLevel, 0));
+
+    // Chunk is lit as if it was alone in the world, with the origin chunk position
+    LightEngine engine(registry, [](std::pair<int, int>, std::shared_ptr<const Chunk>&, std::shared_ptr<const ChunkLight>&) { return false; });
+    std::unique_ptr<WorkChunk> work = std::make_unique<WorkChunk>();
+    work->chunk = std::shared_ptr<const Chunk>(std::shared_ptr<const Chunk>(), &chunk);
+    work->changedLight = light;
+    WorkChunk* workChunk = work.get();
+    engine.chunks_[std::make_pair(0, 0)] = std::move(work);
+
+    // Everything below the first opaque block of a column starts dark
+    int tops[Chunk::LayerBlocksNumber];
+    for (int y = 0; y < (int)Chunk::Width; y++)
+    {
+      for (int x = 0; x < (int)Chunk::Length; x++)
+      {
+        int top = 0;
+        for (int z = (int)Chunk::Height - 1; z >= 0; z--)
+        {
+          if (engine.IsOpaque(chunk.blocks[GetBlockIndex(glm::ivec3(x, y, z))]))
+          {
+            top = z + 1;
+            break;
+          }
+        }
+        tops[x + y * Chunk::Width] = top;
+
+        for (int z = 0; z < top; z++)
+        {
+          light->Set(glm::ivec3(x, y, z), 0);
+        }
+      }
+    }
+
+    // Sky spreads sideways only from cells next to a darker column
+    std::deque<glm::ivec3> skyQueue;
+    for (int y = 0; y < (int)Chunk::Width; y++)
+    {
+      for (int x = 0; x < (int)Chunk::Length; x++)
+      {
+        int neighbourTop = 0;
+        for (int i = 0; i < 4; i++)
+        {
+          int neighbourX = x + Neighbours[i].x;
+          int neighbourY = y + Neighbours[i].y;
+          if (neighbourX >= 0 && neighbourX < (int)Chunk::Length && neighbourY >= 0 && neighbourY < (int)Chunk::Width)
+          {
+            neighbourTop = std::max(neighbourTop, tops[neighbourX + neighbourY * Chunk::Width]);
+          }
+        }
+
+        for (int z = tops[x + y * Chunk::Width]; z < neighbourTop; z++)
+        {
+          skyQueue.push_back(glm::ivec3(x, y, z));
+        }
+      }
+    }
+    engine.PropagateIncrease(Sky, skyQueue);
+
+    std::deque<glm::ivec3> blockQueue;
+    for (int z = 0; z < (int)Chunk::Height; z++)
+    {
+      for (int y = 0; y < (int)Chunk::Width; y++)
+      {
+        for (int x = 0; x < (int)Chunk::Length; x++)
+        {
+          std::uint8_t emission = engine.GetEmission(chunk.blocks[GetBlockIndex(glm::ivec3(x, y, z))]);
+          if (emission != 0)
+          {
+            engine.SetLevel(workChunk, glm::ivec3(x, y, z), BlockLight, emission);
+            blockQueue.push_back(glm::ivec3(x, y, z));
+          }
+        }
+      }
+    }
+    engine.PropagateIncrease(BlockLight, blockQueue);
+
+    light->Compact();
+    return light;
+  }
+
+
+  void LightEngine::AttachChunk(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk, std::shared_ptr<ChunkLight> light)
+  {
+    std::unique_ptr<WorkChunk> work = std::make_unique<WorkChunk>();
+    work->chunk = chunk;
+    work->changedLight = light;
+    chunks_[position] = std::move(work);
+    lastChunk_ = nullptr;
+
+    // Both sides of every shared border spread into each other
+    std::deque<glm::ivec3> skyQueue;
+    std::deque<glm::ivec3> blockQueue;
+    glm::ivec3 chunkOrigin = glm::ivec3(position.first * (int)Chunk::Length, position.second * (int)Chunk::Width, 0);
+    for (int i = 0; i < 4; i++)
+    {
+      glm::ivec3 localCell;
+      if (!GetWorkChunk(chunkOrigin + Neighbours[i] * (int)Chunk::Length, localCell))
+      {
+        continue;
+      }
+
+      for (int z = 0; z < (int)Chunk::Height; z++)
+      {
+        for (int t = 0; t < (int)Chunk::Length; t++)
+        {
+          // Border cell inside the chunk and the cell across the border
+          glm::ivec3 cell = chunkOrigin + glm::ivec3(
+            Neighbours[i].x != 0 ? (Neighbours[i].x > 0 ? (int)Chunk::Length - 1 : 0) : t,
+            Neighbours[i].y != 0 ? (Neighbours[i].y > 0 ? (int)Chunk::Width - 1 : 0) : t,
+            z);
+
+          for (glm::ivec3 borderCell : { cell, cell + Neighbours[i] })
+          {
+            WorkChunk* borderWork = GetWorkChunk(borderCell, localCell);
+            if (GetLevel(borderWork, localCell, Sky) > 1)
+            {
+              skyQueue.push_back(borderCell);
+            }
+            if (GetLevel(borderWork, localCell, BlockLight) > 1)
+            {
+              blockQueue.push_back(borderCell);
+            }
+          }
+        }
+      }
+    }
+
+    PropagateIncrease(Sky, skyQueue);
+    PropagateIncrease(BlockLight, blockQueue);
+  }
+
+  void LightEngine::UpdateBlock(glm::ivec3 cell)
+  {
+    glm::ivec3 localCell;
+    WorkChunk* work = GetWorkChunk(cell, localCell);
+    if (!work)
+    {
+      return;
+    }
+
+    Block block = work->chunk->blocks[GetBlockIndex(localCell)];
+    for (Channel channel : { Sky, BlockLight })
+    {
+      // Light that came through or from the old block is removed, then refilled from what is left around
+      std::deque<std::pair<glm::ivec3, std::uint8_t>> decreaseQueue;
+      std::deque<glm::ivec3> increaseQueue;
+
+      std::uint8_t level = GetLevel(work, localCell, channel);
+      if (level != 0)
+      {
+        SetLevel(work, localCell, channel, 0);
+        decreaseQueue.push_back(std::make_pair(cell, level));
+      }
+      PropagateDecrease(channel, decreaseQueue, increaseQueue);
+
+      work = GetWorkChunk(cell, localCell);
+      if (channel == BlockLight && GetEmission(block) != 0)
+      {
+        SetLevel(work, localCell, channel, GetEmission(block));
+        increaseQueue.push_back(cell);
+      }
+      else if (channel == Sky && cell.z == (int)Chunk::Height - 1 && !IsOpaque(block))
+      {
+        // Nothing above the top layer, it is lit straight from the sky
+        SetLevel(work, localCell, channel, ChunkLight::MaxLevel);
+        increaseQueue.push_back(cell);
+      }
+
+      if (!IsOpaque(block))
+      {
+        for (const glm::ivec3& neighbour : Neighbours)
+        {
+          increaseQueue.push_back(cell + neighbour);
+        }
+      }
+      PropagateIncrease(channel, increaseQueue);
+    }
+  }
+
+
+  std::vector<std::pair<std::pair<int, int>, std::shared_ptr<ChunkLight>>> LightEngine::TakeChangedLights()
+  {
+    std::vector<std::pair<std::pair<int, int>, std::shared_ptr<ChunkLight>>> lights;
+    for (auto& [position, work] : chunks_)
+    {
+      if (work && work->changedLight)
+      {
+        work->changedLight->Compact();
+        lights.emplace_back(position, work->changedLight);
+        work->light = work->changedLight;
+        work->changedLight = nullptr;
+      }
+    }
+
+    return lights;
+  }
+
+
+  LightEngine::WorkChunk* LightEngine::GetWorkChunk(glm::ivec3 cell, glm::ivec3& localCell)
+  {
+    std::pair<int, int> position = std::make_pair(floorDivide(cell.x, Chunk::Length), floorDivide(cell.y, Chunk::Width));
+    localCell = glm::ivec3(cell.x - position.first * (int)Chunk::Length, cell.y - position.second * (int)Chunk::Width, cell.z);
+    if (lastChunk_ && position == lastPosition_)
+    {
+      return lastChunk_;
+    }
+
+    auto it = chunks_.find(position);
+    if (it == chunks_.end())
+    {
+      std::unique_ptr<WorkChunk> work = std::make_unique<WorkChunk>();
+      if (!source_(position, work->chunk, work->light))
+      {
+        work = nullptr;
+      }
+      it = chunks_.emplace(position, std::move(work)).first;
+    }
+
+    lastPosition_ = position;
+    lastChunk_ = it->second.get();
+    return lastChunk_;
+  }
+
+
+  bool LightEngine::IsOpaque(Block block) const
+  {
+    return registry_ ? registry_->IsOpaque(block) : block != 0;
+  }
+
+  std::uint8_t LightEngine::GetEmission(Block block) const
+  {
+    return registry_ ? std::min(registry_->GetLightEmission(block), ChunkLight::MaxLevel) : 0;
+  }
+
+
+  std::uint8_t LightEngine::GetLevel(WorkChunk* work, glm::ivec3 localCell, Channel channel) const
+  {
+    std::uint8_t light = work->changedLight ? work->changedLight->Get(localCell) : work->light->Get(localCell);
+    return (light >> channel) & 0x0F;
+  }
+
+  void LightEngine::SetLevel(WorkChunk* work, glm::ivec3 localCell, Channel channel, std::uint8_t level)
+  {
+    if (!work->changedLight)
+    {
+      work->changedLight = std::make_shared<ChunkLight>(*work->light);
+    }
+
+    std::uint8_t light = work->changedLight->Get(localCell);
+    work->changedLight->Set(localCell, (std::uint8_t)((light & ~(0x0F << channel)) | (level << channel)));
+  }
+
+
+  void LightEngine::PropagateIncrease(Channel channel, std::deque<glm::ivec3>& queue)
+  {
+    while (!queue.empty())
+    {
+      glm::ivec3 cell = queue.front();
+      queue.pop_front();
+
+      glm::ivec3 localCell;
+      WorkChunk* work = GetWorkChunk(cell, localCell);
+      if (!work || cell.z < 0 || cell.z >= (int)Chunk::Height)
+      {
+        continue;
+      }
+
+      std::uint8_t level = GetLevel(work, localCell, channel);
+      if (level <= 1)
+      {
+        continue;
+      }
+
+      for (const glm::ivec3& neighbour : Neighbours)
+      {
+        glm::ivec3 neighbourCell = cell + neighbour;
+        if (neighbourCell.z < 0 || neighbourCell.z >= (int)Chunk::Height)
+        {
+          continue;
+        }
+
+        glm::ivec3 neighbourLocalCell;
+        WorkChunk* neighbourWork = GetWorkChunk(neighbourCell, neighbourLocalCell);
+        if (!neighbourWork || IsOpaque(neighbourWork->chunk->blocks[GetBlockIndex(neighbourLocalCell)]))
+        {
+          continue;
+        }
+
+        // Full sky light falls straight down without fading
+        std::uint8_t neighbourLevel = channel == Sky && neighbour.z < 0 && level == ChunkLight::MaxLevel ? level : level - 1;
+        if (GetLevel(neighbourWork, neighbourLocalCell, channel) < neighbourLevel)
+        {
+          SetLevel(neighbourWork, neighbourLocalCell, channel, neighbourLevel);
+          queue.push_back(neighbourCell);
+        }
+      }
+    }
+  }
+
+  void LightEngine::PropagateDecrease(Channel channel, std::deque<std::pair<glm::ivec3, std::uint8_t>>& queue, std::deque<glm::ivec3>& increaseQueue)
+  {
+    while (!queue.empty())
+    {
+      auto [cell, level] = queue.front();
+      queue.pop_front();
+
+      for (const glm::ivec3& neighbour : Neighbours)
+      {
+        glm::ivec3 neighbourCell = cell + neighbour;
+        if (neighbourCell.z < 0 || neighbourCell.z >= (int)Chunk::Height)
+        {
+          continue;
+        }
+
+        glm::ivec3 neighbourLocalCell;
+        WorkChunk* neighbourWork = GetWorkChunk(neighbourCell, neighbourLocalCell);
+        if (!neighbourWork)
+        {
+          continue;
+        }
+
+        std::uint8_t neighbourLevel = GetLevel(neighbourWork, neighbourLocalCell, channel);
+        if (neighbourLevel == 0)
+        {
+          continue;
+        }
+
+        bool isDependent = neighbourLevel < level || (channel == Sky && neighbour.z < 0 && level == ChunkLight::MaxLevel && neighbourLevel == ChunkLight::MaxLevel);
+        if (!isDependent)
+        {
+          // Lit from elsewhere, it refills the cleared area afterwards
+          increaseQueue.push_back(neighbourCell);
+          continue;
+        }
+
+        SetLevel(neighbourWork, neighbourLocalCell, channel, 0);
+        queue.push_back(std::make_pair(neighbourCell, neighbourLevel));
+
+        std::uint8_t emission = channel == BlockLight ? GetEmission(neighbourWork->chunk->blocks[GetBlockIndex(neighbourLocalCell)]) : 0;
+        if (emission != 0)
+        {
+          SetLevel(neighbourWork, neighbourLocalCell, channel, emission);
+          increaseQueue.push_back(neighbourCell);
+        }
+      }
+    }
+  }
+}
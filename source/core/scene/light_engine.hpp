@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "chunk.hpp"
+#include "chunk_light.hpp"
+#include "resource/block_registry.hpp"
+
+
+namespace blocks
+{
+  // Breadth first sky and block light propagation over a set of chunks fetched on demand.
+  // Lights are copied before the first change and handed back by TakeChangedLights, published ones are never touched.
+  class LightEngine
+  {
+  public:
+    // Returns false when the chunk is not resident or not lit yet, light stops at such chunks
+    typedef std::function<bool(std::pair<int, int> position, std::shared_ptr<const Chunk>& chunk, std::shared_ptr<const ChunkLight>& light)> ChunkSource;
+
+    LightEngine(const BlockRegistry* registry, ChunkSource source);
+    LightEngine(const LightEngine&) = delete;
+    LightEngine(LightEngine&& other) = delete;
+    LightEngine& operator=(const LightEngine&) = delete;
+    LightEngine& operator=(LightEngine&& other) = delete;
+
+    // Lights a chunk on its own, light from the neighbours is added by AttachChunk
+    static std::shared_ptr<ChunkLight> ComputeChunk(const Chunk& chunk, const BlockRegistry* registry);
+
+    // Exchanges light over the borders between a freshly computed chunk and its lit neighbours
+    void AttachChunk(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk, std::shared_ptr<ChunkLight> light);
+    // Repairs light around a block that was replaced, the source must already return the edited chunk
+    void UpdateBlock(glm::ivec3 cell);
+
+    std::vector<std::pair<std::pair<int, int>, std::shared_ptr<ChunkLight>>> TakeChangedLights();
+
+  private:
+    struct WorkChunk
+    {
+      std::shared_ptr<const Chunk> chunk;
+      std::shared_ptr<const ChunkLight> light;
+      // Private copy made on the first change
+      std::shared_ptr<ChunkLight> changedLight;
+    };
+
+    enum Channel
+    {
+      Sky = 4,
+      BlockLight = 0
+    };
+
+    WorkChunk* GetWorkChunk(glm::ivec3 cell, glm::ivec3& localCell);
+
+    bool IsOpaque(Block block) const;
+    std::uint8_t GetEmission(Block block) const;
+
+    std::uint8_t GetLevel(WorkChunk* work, glm::ivec3 localCell, Channel channel) const;
+    void SetLevel(WorkChunk* work, glm::ivec3 localCell, Channel channel, std::uint8_t level);
+
+    void PropagateIncrease(Channel channel, std::deque<glm::ivec3>& queue);
+    void PropagateDecrease(Channel channel, std::deque<std::pair<glm::ivec3, std::uint8_t>>& queue, std::deque<glm::ivec3>& increaseQueue);
+
+    const BlockRegistry* registry_;
+    ChunkSource source_;
+    // Null entries cache chunks the source could not provide
+    std::map<std::pair<int, int>, std::unique_ptr<WorkChunk>> chunks_;
+    std::pair<int, int> lastPosition_;
+    WorkChunk* lastChunk_ = nullptr;
+  };
+}
@@ -2,7 +2,15 @@
 
 #include "FastNoise/FastNoise.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <tuple>
+
+#include "resourceConfig.h"
 #include "io/file_api.hpp"
+#include "light_engine.hpp"
+#include "math_utils.hpp"
 
 
 namespace blocks
@@ -19,7 +27,11 @@ namespace blocks
 
   Map::~Map()
   {
-
+    if (spillStorage_)
+    {
+      spillStorage_ = nullptr;
+      blocks::removeDirectory(spillDirectory_);
+    }
   }
 
 
@@ -28,187 +40,708 @@ namespace blocks
     return seed_;
   }
 
-  std::shared_ptr<Chunk> Map::GetChunk(std::pair<int, int> position)
+  std::shared_ptr<const Chunk> Map::GetChunk(std::pair<int, int> position)
   {
-    std::lock_guard<std::mutex> locker(mutex_);
+    std::shared_ptr<WorldStorage> storage;
+    std::shared_ptr<MappedWorldStore> mappedStore;
+    std::shared_ptr<const Chunk> chunk;
+    std::vector<ScheduledTick> chunkTicks;
+    bool isSpilled = false;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
 
-    std::shared_ptr<Chunk> chunk;
+      auto it = chunks_.find(position);
+      if (it != chunks_.end())
+      {
+        it->second.lastAccess = ++accessCounter_;
+        return it->second.chunk;
+      }
 
-    auto it = chunks_.find(position);
-    if (it == chunks_.end())
+      // Evicted while its spill is still being written
+      auto spillingIt = spillingChunks_.find(position);
+      if (spillingIt != spillingChunks_.end())
+      {
+        chunk = spillingIt->second.chunk;
+        chunkTicks = spillingIt->second.ticks;
+        chunks_[position] = ChunkEntry{ chunk, ++accessCounter_, true };
+      }
+
+      storage = storage_;
+      mappedStore = mappedStore_;
+      isSpilled = spilledChunks_.find(position) != spilledChunks_.end();
+      if (isSpilled)
+      {
+        storage = spillStorage_;
+      }
+    }
+
+    if (chunk)
+    {
+      AttachLight(position, chunk);
+      ticks_->AttachChunk(position, chunkTicks);
+      return chunk;
+    }
+
+    // Reading and generation run unlocked so several chunks can be loaded at once
+    if (isSpilled)
+    {
+      // The spill is the only copy of the edits, a chunk that can not be read back stays spilled
+      // and is tried again on the next access instead of being generated over them
+      chunk = storage->ReadChunk(position, &chunkTicks);
+      if (!chunk)
+      {
+        return nullptr;
+      }
+    }
+    else if (mappedStore)
+    {
+      chunk = mappedStore->ReadChunk(position, &chunkTicks);
+    }
+    else if (storage)
+    {
+      chunk = storage->ReadChunk(position, &chunkTicks);
+    }
+
+    bool isGenerated = false;
+    if (!chunk)
     {
       chunk = GenerateChunk(position);
-      chunks_[position] = chunk;
+      isGenerated = true;
+
+      if (mappedStore)
+      {
+        std::shared_ptr<const Chunk> storedChunk = mappedStore->WriteChunk(position, *chunk);
+        if (storedChunk)
+        {
+          chunk = storedChunk;
+          isGenerated = false;
+        }
+      }
     }
-    else
+
+    bool isInserted = false;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      // Another thread may have loaded the same chunk meanwhile, the first one wins
+      auto it = chunks_.end();
+      std::tie(it, isInserted) = chunks_.emplace(position, ChunkEntry{ chunk, ++accessCounter_, isGenerated || isSpilled });
+      if (isInserted && isGenerated)
+      {
+        // Generation is not deterministic, so generated chunks have to be saved
+        dirtyChunks_.insert(position);
+      }
+      chunk = it->second.chunk;
+    }
+
+    if (isInserted)
     {
-      chunk = it->second;
+      AttachLight(position, chunk);
+      ticks_->AttachChunk(position, chunkTicks);
     }
 
     return chunk;
   }
 
-  std::pair<std::map<std::pair<int, int>, std::shared_ptr<Chunk>>::iterator, std::map<std::pair<int, int>, std::shared_ptr<Chunk>>::iterator> Map::GetChunksIterator()
+  std::shared_ptr<const Chunk> Map::FindChunk(std::pair<int, int> position)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    auto it = chunks_.find(position);
+    return it != chunks_.end() ? it->second.chunk : nullptr;
+  }
+
+  void Map::AddChunk(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk)
+  {
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      chunks_[position] = ChunkEntry{ chunk, ++accessCounter_, true };
+      dirtyChunks_.insert(position);
+    }
+
+    AttachLight(position, chunk);
+    ticks_->AttachChunk(position, {});
+  }
+
+  std::shared_ptr<const Chunk> Map::SetBlock(std::pair<int, int> chunkPosition, glm::ivec3 blockPosition, Block block)
   {
-    return std::make_pair(chunks_.begin(), chunks_.end());
+    return SetBlocks(chunkPosition, { std::make_pair(blockPosition, block) });
   }
 
-  void Map::AddChunk(std::pair<int, int> position, std::shared_ptr<Chunk> chunk)
+  std::shared_ptr<const Chunk> Map::SetBlocks(std::pair<int, int> chunkPosition, const std::vector<std::pair<glm::ivec3, Block>>& blocks)
+  {
+    std::shared_ptr<const Chunk> chunk = GetChunk(chunkPosition);
+    if (!chunk)
+    {
+      return nullptr;
+    }
+
+    std::shared_ptr<Chunk> version;
+    std::shared_ptr<const BlockRegistry> registry;
+    std::vector<glm::ivec3> relitCells;
+    bool isResident = false;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      registry = registry_;
+
+      // Published versions are never changed, the edits go to a copy of the latest one
+      auto it = chunks_.find(chunkPosition);
+      if (it != chunks_.end())
+      {
+        chunk = it->second.chunk;
+      }
+
+      version = std::make_shared<Chunk>(*chunk);
+      for (const auto& [blockPosition, block] : blocks)
+      {
+        Block& target = version->blocks[blockPosition.x + blockPosition.y * Chunk::Width + blockPosition.z * Chunk::LayerBlocksNumber];
+
+        // Light only cares about opacity and emission, flowing fluids mostly keep both
+        bool isLightChanged = registry ?
+          registry->IsOpaque(target) != registry->IsOpaque(block) || registry->GetLightEmission(target) != registry->GetLightEmission(block) :
+          (target != 0) != (block != 0);
+        if (isLightChanged)
+        {
+          relitCells.push_back(glm::ivec3(chunkPosition.first * (int)Chunk::Length + blockPosition.x, chunkPosition.second * (int)Chunk::Width + blockPosition.y, blockPosition.z));
+        }
+        target = block;
+      }
+
+      isResident = it != chunks_.end();
+      if (isResident)
+      {
+        if (it->second.occupancy)
+        {
+          std::shared_ptr<ChunkOccupancy> occupancy = std::make_shared<ChunkOccupancy>(*it->second.occupancy);
+          for (const auto& [blockPosition, block] : blocks)
+          {
+            occupancy->Update(*version, blockPosition, [&registry](Block block) { return IsSolid(registry.get(), block); });
+          }
+          it->second.occupancy = occupancy;
+        }
+
+        it->second.chunk = version;
+        it->second.lastAccess = ++accessCounter_;
+        it->second.isModified = true;
+      }
+      else
+      {
+        chunks_.emplace(chunkPosition, ChunkEntry{ version, ++accessCounter_, true });
+      }
+      dirtyChunks_.insert(chunkPosition);
+    }
+
+    // Light is repaired before returning, so the caller meshes the edit already lit
+    if (!isResident)
+    {
+      AttachLight(chunkPosition, version);
+    }
+    else if (!relitCells.empty())
+    {
+      UpdateLight(relitCells);
+    }
+
+    if (registry)
+    {
+      glm::ivec3 chunkOrigin = glm::ivec3(chunkPosition.first * (int)Chunk::Length, chunkPosition.second * (int)Chunk::Width, 0);
+      for (const auto& [blockPosition, block] : blocks)
+      {
+        if (registry->IsTicking(block))
+        {
+          ticks_->Schedule(chunkOrigin + blockPosition, registry->GetTickDelay(block));
+        }
+      }
+    }
+
+    return version;
+  }
+
+
+  ChunkLightView Map::GetLightView(std::pair<int, int> position)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    ChunkLightView view;
+    for (int x = 0; x < 3; x++)
+    {
+      for (int y = 0; y < 3; y++)
+      {
+        auto it = chunks_.find(std::make_pair(position.first + x - 1, position.second + y - 1));
+        view.lights[x][y] = it != chunks_.end() ? it->second.light : nullptr;
+      }
+    }
+
+    return view;
+  }
+
+  std::vector<std::pair<int, int>> Map::TakeRelitChunks()
   {
     std::lock_guard<std::mutex> locker(mutex_);
 
-    chunks_[position] = chunk;
+    std::vector<std::pair<int, int>> positions(relitChunks_.begin(), relitChunks_.end());
+    relitChunks_.clear();
+
+    return positions;
   }
 
 
-  bool Map::Collides(const blocks::AABB& bounds, glm::vec3 position)
+  void Map::MarkChunkDirty(std::pair<int, int> position)
   {
-    std::pair<int, int> chunkPosition = std::make_pair(position.x / Chunk::Length, position.y / Chunk::Width);
-    glm::vec3 localPosition = glm::vec3(position.x - chunkPosition.first * (int)Chunk::Length, position.y - chunkPosition.second * (int)Chunk::Width, position.z);
-    if (localPosition.x < 0)
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    dirtyChunks_.insert(position);
+  }
+
+  size_t Map::GetDirtyChunksNumber()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return dirtyChunks_.size();
+  }
+
+  std::vector<ChunkSnapshot> Map::TakeDirtyChunks()
+  {
+    std::vector<ChunkSnapshot> snapshots;
+    std::vector<std::pair<int, int>> spilledPositions;
+    std::shared_ptr<WorldStorage> spillStorage;
     {
-      localPosition.x += Chunk::Length;
-      chunkPosition.first--;
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      // Current versions are immutable, the saver can keep them without copying
+      snapshots.reserve(dirtyChunks_.size());
+      for (const std::pair<int, int>& position : dirtyChunks_)
+      {
+        auto it = chunks_.find(position);
+        auto spillingIt = spillingChunks_.find(position);
+        if (it != chunks_.end())
+        {
+          snapshots.push_back(ChunkSnapshot{ position, it->second.chunk, ticks_->GetChunkTicks(position) });
+        }
+        else if (spillingIt != spillingChunks_.end())
+        {
+          snapshots.push_back(spillingIt->second);
+        }
+        else if (spilledChunks_.find(position) != spilledChunks_.end())
+        {
+          spilledPositions.push_back(position);
+        }
+      }
+      dirtyChunks_.clear();
+      spillStorage = spillStorage_;
     }
-    if (localPosition.y < 0)
+
+    // Evicted chunks are read back from the spill outside the lock, the spill keeps them until they are loaded again
+    for (const std::pair<int, int>& position : spilledPositions)
     {
-      localPosition.y += Chunk::Width;
-      chunkPosition.second--;
+      ChunkSnapshot snapshot{ position };
+      snapshot.chunk = spillStorage->ReadChunk(position, &snapshot.ticks);
+      if (snapshot.chunk)
+      {
+        snapshots.push_back(std::move(snapshot));
+      }
+      else
+      {
+        MarkChunkDirty(position);
+      }
     }
-    std::shared_ptr<Chunk> chunk = GetChunk(chunkPosition);
 
-    blocks::AABB localBounds(bounds.low + localPosition, bounds.high + localPosition);
+    return snapshots;
+  }
 
-    glm::ivec3 centralBlockPosition = glm::ivec3(localPosition);
+  void Map::MarkChunkSaved(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
 
-    int radius = 2;
-    for (int x = centralBlockPosition.x - radius; x <= centralBlockPosition.x + radius; x++)
+    // Newer edits are still waiting for the next save
+    if (dirtyChunks_.find(position) != dirtyChunks_.end() || spillingChunks_.find(position) != spillingChunks_.end())
     {
-      if (x < 0 || x >= Chunk::Length)
+      return;
+    }
+
+    auto it = chunks_.find(position);
+    if (it != chunks_.end())
+    {
+      if (it->second.chunk != chunk)
       {
-        continue;
+        return;
+      }
+      it->second.isModified = false;
+    }
+
+    // Reloads come from the saved copy from now on, the spill is older than it
+    spilledChunks_.erase(position);
+  }
+
+
+  void Map::SetMemoryBudget(size_t bytes)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    maxChunksNumber_ = std::max<size_t>(bytes / sizeof(Chunk), 1);
+  }
+
+  size_t Map::GetResidentChunksNumber()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return chunks_.size();
+  }
+
+  void Map::EvictChunks(std::pair<int, int> center, int radius)
+  {
+    std::vector<ChunkSnapshot> spills;
+    std::shared_ptr<WorldStorage> spillStorage;
+    std::shared_ptr<MappedWorldStore> mappedStore;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      if (isEvicting_ || chunks_.size() <= maxChunksNumber_)
+      {
+        return;
       }
 
-      for (int y = centralBlockPosition.y - radius; y <= centralBlockPosition.y + radius; y++)
+      // Readers only pin immutable versions, so any chunk outside the area can be dropped
+      std::vector<std::pair<std::uint64_t, std::pair<int, int>>> candidates;
+      for (const auto& [position, entry] : chunks_)
       {
-        if (y < 0 || y >= Chunk::Width)
+        bool isInside = std::abs(position.first - center.first) <= radius && std::abs(position.second - center.second) <= radius;
+        if (!isInside)
         {
-          continue;
+          candidates.emplace_back(entry.lastAccess, position);
         }
+      }
+      std::sort(candidates.begin(), candidates.end());
 
-        for (int z = centralBlockPosition.z - radius; z <= centralBlockPosition.z + radius; z++)
+      if (!mappedStore_ && !spillStorage_)
+      {
+        static std::atomic<int> spillsNumber = 0;
+        spillDirectory_ = std::string(CACHE_DIR) + "spill/" + std::to_string(spillsNumber++);
+
+        blocks::createDirectory(CACHE_DIR);
+        blocks::createDirectory(std::string(CACHE_DIR) + "spill");
+        blocks::removeDirectory(spillDirectory_);
+        spillStorage_ = std::make_shared<WorldStorage>(spillDirectory_);
+      }
+
+      size_t evictNumber = std::min(chunks_.size() - maxChunksNumber_, candidates.size());
+      for (size_t i = 0; i < evictNumber; i++)
+      {
+        auto it = chunks_.find(candidates[i].second);
+
+        // Unmodified chunks can be read again from where they came from, mapped ones are written back to their slot.
+        // Pending updates leave memory with the chunk, they are spilled along with it even when the blocks are saved.
+        std::vector<ScheduledTick> chunkTicks = ticks_->DetachChunk(it->first);
+        if (it->second.isModified || !chunkTicks.empty())
         {
-          if (z < 0 || z >= Chunk::Height)
-          {
-            continue;
-          }
+          ChunkSnapshot spill{ it->first, it->second.chunk, std::move(chunkTicks) };
+          spillingChunks_[it->first] = spill;
+          spills.push_back(std::move(spill));
+        }
+        evictedChunks_.insert(it->first);
+        chunks_.erase(it);
+      }
 
-          if (chunk->blocks[x + y * Chunk::Width + z * Chunk::LayerBlocksNumber] == 0)
-          {
-            continue;
-          }
+      isEvicting_ = !spills.empty();
+      spillStorage = spillStorage_;
+      mappedStore = mappedStore_;
+    }
 
-          blocks::AABB blockBounds(glm::vec3(x, y, z), glm::vec3(x + 1, y + 1, z + 1));
-          if (CheckCollision(blockBounds, localBounds))
-          {
-            return true;
-          }
+    if (spills.empty())
+    {
+      return;
+    }
+
+    std::vector<bool> isWritten(spills.size());
+    for (size_t i = 0; i < spills.size(); i++)
+    {
+      const auto& [position, chunk, chunkTicks] = spills[i];
+      isWritten[i] = mappedStore ? mappedStore->StoreChunk(position, chunk, chunkTicks) : spillStorage->WriteChunk(position, *chunk, chunkTicks) != 0;
+    }
+
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    for (size_t i = 0; i < spills.size(); i++)
+    {
+      const auto& [position, chunk, chunkTicks] = spills[i];
+      spillingChunks_.erase(position);
+
+      if (isWritten[i] && !mappedStore)
+      {
+        spilledChunks_.insert(position);
+      }
+      else if (!isWritten[i])
+      {
+        // Nowhere to put it, keep the chunk resident
+        auto [it, isInserted] = chunks_.emplace(position, ChunkEntry{ chunk, ++accessCounter_, true });
+        if (isInserted)
+        {
+          ticks_->AttachChunk(position, chunkTicks);
         }
       }
     }
+    isEvicting_ = false;
+  }
+
+  std::vector<std::pair<int, int>> Map::TakeEvictedChunks()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
 
-    return false;
+    std::vector<std::pair<int, int>> positions(evictedChunks_.begin(), evictedChunks_.end());
+    evictedChunks_.clear();
+
+    return positions;
   }
 
-  BlockLookAt Map::GetBlockLookAt(const blocks::Ray& ray)
+
+  void Map::SetBlockRegistry(std::shared_ptr<const BlockRegistry> registry)
   {
-    std::pair<int, int> chunkPosition = std::make_pair(ray.origin.x / Chunk::Length, ray.origin.y / Chunk::Width);
-    glm::vec3 localPosition = glm::vec3(ray.origin.x - chunkPosition.first * (int)Chunk::Length, ray.origin.y - chunkPosition.second * (int)Chunk::Width, ray.origin.z);
-    if (localPosition.x < 0)
+    std::vector<std::pair<std::pair<int, int>, std::shared_ptr<const Chunk>>> residentChunks;
     {
-      localPosition.x += Chunk::Length;
-      chunkPosition.first--;
+      // Light writers wait until every cached light is dropped, none of them publishes light of the old registry
+      std::lock_guard<std::mutex> lightLocker(lightMutex_);
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      if (registry_ == registry)
+      {
+        return;
+      }
+      registry_ = registry;
+
+      // Solidity and emission may differ, occupancy is rebuilt on the next ray query
+      residentChunks.reserve(chunks_.size());
+      for (auto& [position, entry] : chunks_)
+      {
+        entry.occupancy = nullptr;
+        entry.light = nullptr;
+        residentChunks.emplace_back(position, entry.chunk);
+      }
     }
-    if (localPosition.y < 0)
+
+    for (const auto& [position, chunk] : residentChunks)
     {
-      localPosition.y += Chunk::Width;
-      chunkPosition.second--;
+      AttachLight(position, chunk);
     }
+  }
 
-    std::shared_ptr<Chunk> chunk = GetChunk(chunkPosition);
-    blocks::Ray localRay(localPosition, ray.direction);
+  std::shared_ptr<const BlockRegistry> Map::GetBlockRegistry()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return registry_;
+  }
+
+  std::shared_ptr<BlockTicks> Map::GetBlockTicks()
+  {
+    return ticks_;
+  }
 
-    glm::ivec3 centralBlockPosition = glm::ivec3(localPosition);
+  std::shared_ptr<WorldStorage> Map::GetStorage()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return storage_;
+  }
 
-    blocks::RayIntersectionPoint closestIntersectionPoint;
-    glm::ivec3 intersectedBlock;
-    int radius = 3;
-    for (int x = centralBlockPosition.x - radius; x <= centralBlockPosition.x + radius; x++)
+  void Map::SetStorage(std::shared_ptr<WorldStorage> storage)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    storage_ = storage;
+  }
+
+  std::shared_ptr<MappedWorldStore> Map::GetMappedStore()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return mappedStore_;
+  }
+
+  void Map::SetMappedStore(std::shared_ptr<MappedWorldStore> mappedStore)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    mappedStore_ = mappedStore;
+  }
+
+  void Map::SetActiveArea(std::pair<int, int> center, int radius)
+  {
+    std::shared_ptr<MappedWorldStore> mappedStore = GetMappedStore();
+    if (mappedStore)
+    {
+      mappedStore->SetActiveArea(center, radius);
+    }
+  }
+
+
+  glm::vec3 Map::MoveBox(const blocks::AABB& bounds, glm::vec3 position, glm::vec3 shift, glm::bvec3* blockedAxes)
+  {
+    // Gap kept to obstacles so rounding never leaves the box touching the cells it slides along
+    static const float Skin = 1e-4f;
+
+    std::shared_ptr<const BlockRegistry> registry = GetBlockRegistry();
+    std::shared_ptr<const Chunk> chunk;
+    std::pair<int, int> chunkPosition;
+
+    if (blockedAxes)
+    {
+      *blockedAxes = glm::bvec3(false);
+    }
+
+    for (int axis = 0; axis < 3; axis++)
     {
-      if (x < 0 || x >= Chunk::Length)
+      if (shift[axis] == 0.0f)
       {
         continue;
       }
 
-      for (int y = centralBlockPosition.y - radius; y <= centralBlockPosition.y + radius; y++)
+      glm::vec3 low = position + bounds.low;
+      glm::vec3 high = position + bounds.high;
+
+      // Cells overlapped across the sweep direction, touching faces do not count
+      glm::ivec3 firstCell = glm::ivec3(glm::floor(low + Skin));
+      glm::ivec3 lastCell = glm::ivec3(glm::ceil(high - Skin)) - 1;
+
+      // Layers are visited from the leading face on, cells the box already overlaps are ignored so it can get out of them
+      float allowedShift = shift[axis];
+      int step = shift[axis] > 0.0f ? 1 : -1;
+      int layer = step > 0 ? (int)std::ceil(high[axis] - Skin) : (int)std::floor(low[axis] + Skin) - 1;
+      for (;; layer += step)
       {
-        if (y < 0 || y >= Chunk::Width)
+        float layerDistance = step > 0 ? (float)layer - high[axis] : low[axis] - (float)(layer + 1);
+        if (layerDistance >= std::abs(allowedShift))
         {
-          continue;
+          break;
         }
 
-        for (int z = centralBlockPosition.z - radius; z <= centralBlockPosition.z + radius; z++)
+        bool isBlocked = false;
+        glm::ivec3 cell;
+        cell[axis] = layer;
+        int axis1 = (axis + 1) % 3;
+        int axis2 = (axis + 2) % 3;
+        for (cell[axis1] = firstCell[axis1]; cell[axis1] <= lastCell[axis1] && !isBlocked; cell[axis1]++)
         {
-          if (z < 0 || z >= Chunk::Height)
-          {
-            continue;
-          }
-
-          if (chunk->blocks[x + y * Chunk::Width + z * Chunk::LayerBlocksNumber] == 0)
+          for (cell[axis2] = firstCell[axis2]; cell[axis2] <= lastCell[axis2] && !isBlocked; cell[axis2]++)
           {
-            continue;
+            isBlocked = IsSolidCell(registry.get(), cell, chunk, chunkPosition);
           }
+        }
 
-          blocks::AABB blockBounds(glm::vec3(x, y, z), glm::vec3(x + 1, y + 1, z + 1));
-          blocks::RayIntersectionPoint intersectionPoint = CheckCollision(localRay, blockBounds);
-          if (intersectionPoint.distance != FLT_MAX && closestIntersectionPoint.distance > intersectionPoint.distance)
+        if (isBlocked)
+        {
+          allowedShift = step * std::max(layerDistance - Skin, 0.0f);
+          if (blockedAxes)
           {
-            closestIntersectionPoint = intersectionPoint;
-            intersectedBlock = glm::ivec3(x, y, z);
+            (*blockedAxes)[axis] = true;
           }
+          break;
         }
       }
+
+      position[axis] += allowedShift;
     }
 
+    return position;
+  }
+
+  BlockLookAt Map::GetBlockLookAt(const blocks::Ray& ray, float maxDistance)
+  {
     BlockLookAt result;
-    result.chunkPosition = chunkPosition;
-    result.blockPosition = intersectedBlock;
-    if (closestIntersectionPoint.distance != FLT_MAX)
+    if (glm::length(ray.direction) == 0.0f)
     {
-      result.hit = true;
-      if (closestIntersectionPoint.point.x == (float)intersectedBlock.x)
-      {
-        result.loockFromDirection = Direction::Back;
-      }
-      else if (closestIntersectionPoint.point.x == (float)(intersectedBlock.x + 1))
-      {
-        result.loockFromDirection = Direction::Forward;
-      }
-      else if (closestIntersectionPoint.point.y == (float)intersectedBlock.y)
+      return result;
+    }
+
+    // Every step leaves an aligned box through its nearest face, a box is a single block, an empty cell or an empty region.
+    // Distances are always measured from the origin so long skips do not accumulate error.
+    glm::vec3 direction = glm::normalize(ray.direction);
+    glm::ivec3 cell = glm::ivec3(glm::floor(ray.origin));
+    float distance = 0.0f;
+    int axis = -1;
+
+    std::shared_ptr<const BlockRegistry> registry = GetBlockRegistry();
+    std::shared_ptr<const Chunk> chunk;
+    std::shared_ptr<const ChunkOccupancy> occupancy;
+    std::pair<int, int> chunkPosition;
+
+    while (distance <= maxDistance)
+    {
+      // Nothing above or below the map, stop once the ray leaves it for good
+      if ((cell.z < 0 && direction.z <= 0.0f) || (cell.z >= (int)Chunk::Height && direction.z >= 0.0f))
       {
-        result.loockFromDirection = Direction::Left;
+        break;
       }
-      else if (closestIntersectionPoint.point.y == (float)(intersectedBlock.y + 1))
+
+      int boxSize = ChunkOccupancy::RegionSize;
+      if (cell.z >= 0 && cell.z < (int)Chunk::Height)
       {
-        result.loockFromDirection = Direction::Right;
+        std::pair<int, int> cellChunkPosition = std::make_pair(floorDivide(cell.x, Chunk::Length), floorDivide(cell.y, Chunk::Width));
+        if (!chunk || cellChunkPosition != chunkPosition)
+        {
+          occupancy = FindOccupancy(cellChunkPosition, chunk);
+          chunkPosition = cellChunkPosition;
+          if (!chunk)
+          {
+            break;
+          }
+        }
+
+        glm::ivec3 blockPosition = glm::ivec3(cell.x - chunkPosition.first * (int)Chunk::Length, cell.y - chunkPosition.second * (int)Chunk::Width, cell.z);
+        if (!occupancy->IsRegionEmpty(blockPosition.z))
+        {
+          boxSize = ChunkOccupancy::CellSize;
+          if (!occupancy->IsCellEmpty(blockPosition))
+          {
+            boxSize = 1;
+
+            // The block containing the origin is never picked
+            if (axis != -1 && IsSolid(registry.get(), chunk->blocks[blockPosition.x + blockPosition.y * Chunk::Width + blockPosition.z * Chunk::LayerBlocksNumber]))
+            {
+              result.hit = true;
+              result.chunkPosition = chunkPosition;
+              result.blockPosition = blockPosition;
+              result.normal = glm::ivec3(0);
+              result.normal[axis] = direction[axis] > 0.0f ? -1 : 1;
+              result.distance = distance;
+
+              static const Direction directions[3][2] = { { Direction::Back, Direction::Forward }, { Direction::Left, Direction::Right }, { Direction::Down, Direction::Up } };
+              result.loockFromDirection = directions[axis][result.normal[axis] > 0 ? 1 : 0];
+              break;
+            }
+          }
+        }
       }
-      else if (closestIntersectionPoint.point.z == (float)intersectedBlock.z)
+
+      glm::ivec3 boxLow = glm::ivec3(floorDivide(cell.x, boxSize), floorDivide(cell.y, boxSize), floorDivide(cell.z, boxSize)) * boxSize;
+      glm::ivec3 boxHigh = boxLow + boxSize;
+
+      float exitDistance = FLT_MAX;
+      for (int i = 0; i < 3; i++)
       {
-        result.loockFromDirection = Direction::Down;
+        float faceDistance = FLT_MAX;
+        if (direction[i] > 0.0f)
+        {
+          faceDistance = ((float)boxHigh[i] - ray.origin[i]) / direction[i];
+        }
+        else if (direction[i] < 0.0f)
+        {
+          faceDistance = ((float)boxLow[i] - ray.origin[i]) / direction[i];
+        }
+
+        if (faceDistance < exitDistance)
+        {
+          exitDistance = faceDistance;
+          axis = i;
+        }
       }
-      else if (closestIntersectionPoint.point.z == (float)(intersectedBlock.z + 1))
+
+      distance = std::max(exitDistance, distance);
+      glm::vec3 point = ray.origin + direction * distance;
+      for (int i = 0; i < 3; i++)
       {
-        result.loockFromDirection = Direction::Up;
+        // Rounding must not move the ray back into the box or past its sides
+        cell[i] = i == axis ? (direction[i] > 0.0f ? boxHigh[i] : boxLow[i] - 1) : std::clamp((int)std::floor(point[i]), boxLow[i], boxHigh[i] - 1);
       }
     }
 
@@ -222,50 +755,155 @@ namespace blocks
     int seed = std::stoi(seedStr);
 
     std::shared_ptr<Map> map = std::make_shared<Map>(seed);
+    if (blocks::isPathExist("map/mapped"))
+    {
+      map->SetMappedStore(std::make_shared<MappedWorldStore>("map/mapped"));
+    }
+    else
+    {
+      map->SetStorage(std::make_shared<WorldStorage>("map"));
+    }
+
+    return map;
+  }
 
-    for (const std::string& path : blocks::getFilesInDirectory("map"))
+
+  bool Map::IsSolidCell(const BlockRegistry* registry, glm::ivec3 cell, std::shared_ptr<const Chunk>& chunk, std::pair<int, int>& chunkPosition)
+  {
+    if (cell.z < 0 || cell.z >= (int)Chunk::Height)
+    {
+      return false;
+    }
+
+    std::pair<int, int> cellChunkPosition = std::make_pair(floorDivide(cell.x, Chunk::Length), floorDivide(cell.y, Chunk::Width));
+    if (!chunk || cellChunkPosition != chunkPosition)
     {
-      if (path == "seed.txt")
+      chunk = FindChunk(cellChunkPosition);
+      chunkPosition = cellChunkPosition;
+    }
+
+    // Chunks that are not resident block movement rather than being loaded or letting boxes fall through them
+    if (!chunk)
+    {
+      return true;
+    }
+
+    int x = cell.x - chunkPosition.first * (int)Chunk::Length;
+    int y = cell.y - chunkPosition.second * (int)Chunk::Width;
+    return IsSolid(registry, chunk->blocks[x + y * Chunk::Width + cell.z * Chunk::LayerBlocksNumber]);
+  }
+
+  std::shared_ptr<const ChunkOccupancy> Map::FindOccupancy(std::pair<int, int> position, std::shared_ptr<const Chunk>& chunk)
+  {
+    std::shared_ptr<const BlockRegistry> registry;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      auto it = chunks_.find(position);
+      if (it == chunks_.end())
       {
-        continue;
+        chunk = nullptr;
+        return nullptr;
       }
 
-      std::vector<unsigned char> data = blocks::readBinaryFile("map/" + path);
-      std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
-      memcpy(chunk.get(), &data[0], sizeof(Chunk));
+      chunk = it->second.chunk;
+      if (it->second.occupancy)
+      {
+        return it->second.occupancy;
+      }
+      registry = registry_;
+    }
 
-      size_t underscorePosition = path.find("_");
-      size_t dotPosition = path.find(".");
+    // Built unlocked, kept only if no edit or registry change happened meanwhile
+    std::shared_ptr<const ChunkOccupancy> occupancy = std::make_shared<ChunkOccupancy>(ChunkOccupancy::Build(*chunk, [&registry](Block block) { return IsSolid(registry.get(), block); }));
 
-      std::string xStr = path.substr(0, underscorePosition);
-      int x = std::stoi(xStr);
-      std::string yStr = path.substr(underscorePosition + 1, dotPosition - underscorePosition - 1);
-      int y = std::stoi(yStr);
-      std::pair<int, int> position = std::make_pair(x, y);
+    std::lock_guard<std::mutex> locker(mutex_);
 
-      map->AddChunk(position, chunk);
+    auto it = chunks_.find(position);
+    if (it != chunks_.end() && it->second.chunk == chunk && !it->second.occupancy && registry_ == registry)
+    {
+      it->second.occupancy = occupancy;
     }
 
-    return map;
+    return occupancy;
+  }
+
+  void Map::AttachLight(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk)
+  {
+    // The heavy part runs before taking the light lock
+    std::shared_ptr<const BlockRegistry> registry = GetBlockRegistry();
+    std::shared_ptr<ChunkLight> light = LightEngine::ComputeChunk(*chunk, registry.get());
+
+    std::lock_guard<std::mutex> lightLocker(lightMutex_);
+
+    std::shared_ptr<const Chunk> currentChunk;
+    std::shared_ptr<const BlockRegistry> currentRegistry;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      // Evicted already or lit by another loader
+      auto it = chunks_.find(position);
+      if (it == chunks_.end() || it->second.light)
+      {
+        return;
+      }
+      currentChunk = it->second.chunk;
+      currentRegistry = registry_;
+    }
+
+    // Edited while the light was computed, edits of lit chunks and registry changes only come after this point
+    if (currentChunk != chunk || currentRegistry != registry)
+    {
+      light = LightEngine::ComputeChunk(*currentChunk, currentRegistry.get());
+    }
+
+    LightEngine engine(currentRegistry.get(), [this](std::pair<int, int> litPosition, std::shared_ptr<const Chunk>& litChunk, std::shared_ptr<const ChunkLight>& litLight) { return FindLitChunk(litPosition, litChunk, litLight); });
+    engine.AttachChunk(position, currentChunk, light);
+    PublishLights(engine.TakeChangedLights());
   }
 
-  void Map::Save(std::shared_ptr<Map> map)
+  void Map::UpdateLight(const std::vector<glm::ivec3>& cells)
   {
-    blocks::saveTextFile("map/seed.txt", std::to_string(map->GetSeed()));
+    std::lock_guard<std::mutex> lightLocker(lightMutex_);
 
-    auto chunksIterator = map->GetChunksIterator();
-    for (auto it = chunksIterator.first; it != chunksIterator.second; it++)
+    std::shared_ptr<const BlockRegistry> registry = GetBlockRegistry();
+    LightEngine engine(registry.get(), [this](std::pair<int, int> litPosition, std::shared_ptr<const Chunk>& litChunk, std::shared_ptr<const ChunkLight>& litLight) { return FindLitChunk(litPosition, litChunk, litLight); });
+    for (const glm::ivec3& cell : cells)
     {
-      std::string path = std::format("map/{0}_{1}.chunk", it->first.first, it->first.second);
+      engine.UpdateBlock(cell);
+    }
+    PublishLights(engine.TakeChangedLights());
+  }
 
-      size_t a = sizeof(Chunk);
-      std::vector<unsigned char> data(sizeof(Chunk));
-      memcpy(&data[0], it->second.get(), sizeof(Chunk));
+  void Map::PublishLights(const std::vector<std::pair<std::pair<int, int>, std::shared_ptr<ChunkLight>>>& lights)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
 
-      blocks::saveBinaryFile(path, data);
+    for (const auto& [position, light] : lights)
+    {
+      auto it = chunks_.find(position);
+      if (it != chunks_.end())
+      {
+        it->second.light = light;
+        relitChunks_.insert(position);
+      }
     }
   }
 
+  bool Map::FindLitChunk(std::pair<int, int> position, std::shared_ptr<const Chunk>& chunk, std::shared_ptr<const ChunkLight>& light)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    auto it = chunks_.find(position);
+    if (it == chunks_.end() || !it->second.light)
+    {
+      return false;
+    }
+
+    chunk = it->second.chunk;
+    light = it->second.light;
+    return true;
+  }
 
   std::shared_ptr<Chunk> Map::GenerateChunk(std::pair<int, int> position)
   {
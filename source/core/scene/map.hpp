@@ -4,37 +4,144 @@
 #include <map>
 #include <memory>
 #include <mutex>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "block_look_at.hpp"
+#include "block_ticks.hpp"
 #include "chunk.hpp"
+#include "chunk_light.hpp"
+#include "chunk_occupancy.hpp"
 #include "geometry/collisions_api.hpp"
+#include "resource/block_registry.hpp"
+#include "world_storage.hpp"
+#include "mapped_world_store.hpp"
 
 
 namespace blocks
 {
+  // Version of a chunk taken for saving together with its pending block updates
+  struct ChunkSnapshot
+  {
+    std::pair<int, int> position;
+    std::shared_ptr<const Chunk> chunk;
+    std::vector<ScheduledTick> ticks;
+  };
+
   class Map
   {
   public:
+    static const size_t DefaultMemoryBudget = 256 * 1024 * 1024;
+    static constexpr float DefaultReachDistance = 8.0f;
+
     Map();
     Map(int seed);
     ~Map();
 
     int GetSeed();
-    std::shared_ptr<Chunk> GetChunk(std::pair<int, int> position);
-    std::pair<std::map<std::pair<int, int>, std::shared_ptr<Chunk>>::iterator, std::map<std::pair<int, int>, std::shared_ptr<Chunk>>::iterator> GetChunksIterator();
+    // Returned chunk is an immutable version, edits publish a new one.
+    // Returns nullptr when an evicted chunk can not be read back from its spill.
+    std::shared_ptr<const Chunk> GetChunk(std::pair<int, int> position);
+    // Returns nullptr instead of loading or generating the chunk
+    std::shared_ptr<const Chunk> FindChunk(std::pair<int, int> position);
+
+    void AddChunk(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk);
+    // Returns nullptr when the chunk can not be loaded
+    std::shared_ptr<const Chunk> SetBlock(std::pair<int, int> chunkPosition, glm::ivec3 blockPosition, Block block);
+    // Publishes a single version for several edits of one chunk
+    std::shared_ptr<const Chunk> SetBlocks(std::pair<int, int> chunkPosition, const std::vector<std::pair<glm::ivec3, Block>>& blocks);
+
+    // Light of the chunk and its neighbours, entries of chunks that are not lit yet are nullptr
+    ChunkLightView GetLightView(std::pair<int, int> position);
+    // Chunks whose light changed since the last call, their meshes are out of date
+    std::vector<std::pair<int, int>> TakeRelitChunks();
+
+    void MarkChunkDirty(std::pair<int, int> position);
+    size_t GetDirtyChunksNumber();
+    std::vector<ChunkSnapshot> TakeDirtyChunks();
+    // The saved copy of the chunk is current again unless it was edited after this version was taken
+    void MarkChunkSaved(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk);
 
-    void AddChunk(std::pair<int, int> position, std::shared_ptr<Chunk> chunk);
+    void SetMemoryBudget(size_t bytes);
+    size_t GetResidentChunksNumber();
+    // Drops least recently used chunks outside the area until the budget holds, modified ones and those with
+    // pending updates are spilled to a scratch storage (or their mapped slot) first and reloaded from it on access
+    void EvictChunks(std::pair<int, int> center, int radius);
+    // Chunks dropped from memory since the last call, caches built from them can be released
+    std::vector<std::pair<int, int>> TakeEvictedChunks();
 
-    bool Collides(const blocks::AABB& bounds, glm::vec3 position);
-    BlockLookAt GetBlockLookAt(const blocks::Ray& ray);
+    // Occupancy and light of resident chunks are rebuilt with the new registry
+    void SetBlockRegistry(std::shared_ptr<const BlockRegistry> registry);
+    std::shared_ptr<const BlockRegistry> GetBlockRegistry();
+    // Pending updates travel with the chunks, edits placing ticking blocks schedule them
+    std::shared_ptr<BlockTicks> GetBlockTicks();
+
+    std::shared_ptr<WorldStorage> GetStorage();
+    void SetStorage(std::shared_ptr<WorldStorage> storage);
+    // Optional backend keeping chunks in mapped files, saves copy edited versions back to their slots
+    std::shared_ptr<MappedWorldStore> GetMappedStore();
+    void SetMappedStore(std::shared_ptr<MappedWorldStore> mappedStore);
+    void SetActiveArea(std::pair<int, int> center, int radius);
+
+    // Sweeps the box one axis at a time, blocked axes stop at the obstacle while the others keep sliding.
+    // Never loads chunks, cells of chunks that are not resident are solid.
+    glm::vec3 MoveBox(const blocks::AABB& bounds, glm::vec3 position, glm::vec3 shift, glm::bvec3* blockedAxes = nullptr);
+    // Walks the ray across resident chunks skipping empty 16^3 regions and 4^3 cells in one step,
+    // stops without a hit at the first chunk that is not loaded
+    BlockLookAt GetBlockLookAt(const blocks::Ray& ray, float maxDistance = DefaultReachDistance);
 
     static std::shared_ptr<Map> Load();
-    static void Save(std::shared_ptr<Map> map);
 
   private:
-    std::map<std::pair<int, int>, std::shared_ptr<Chunk>> chunks_;
+    struct ChunkEntry
+    {
+      std::shared_ptr<const Chunk> chunk;
+      std::uint64_t lastAccess;
+      // Differs from the copy it would be reloaded from, eviction has to spill it
+      bool isModified;
+      // Built on the first ray query and kept in sync by edits
+      std::shared_ptr<const ChunkOccupancy> occupancy = nullptr;
+      // Set once the chunk is lit together with its resident neighbours
+      std::shared_ptr<const ChunkLight> light = nullptr;
+    };
+
+    std::map<std::pair<int, int>, ChunkEntry> chunks_;
+    std::map<std::pair<int, int>, ChunkSnapshot> spillingChunks_;
+    std::set<std::pair<int, int>> spilledChunks_;
+    std::set<std::pair<int, int>> evictedChunks_;
+    std::shared_ptr<WorldStorage> spillStorage_;
+    std::string spillDirectory_;
+    std::uint64_t accessCounter_ = 0;
+    size_t maxChunksNumber_ = DefaultMemoryBudget / sizeof(Chunk);
+    bool isEvicting_ = false;
     int seed_;
     std::mutex mutex_;
+    std::shared_ptr<const BlockRegistry> registry_;
+    std::shared_ptr<BlockTicks> ticks_ = std::make_shared<BlockTicks>();
+    std::shared_ptr<WorldStorage> storage_;
+    std::shared_ptr<MappedWorldStore> mappedStore_;
+    std::set<std::pair<int, int>> dirtyChunks_;
+    // Light writers run one at a time, always locked before mutex_
+    std::mutex lightMutex_;
+    std::set<std::pair<int, int>> relitChunks_;
+
+    // Operations take the registry once, a concurrent SetBlockRegistry does not change it under them
+    static bool IsSolid(const BlockRegistry* registry, Block block)
+    {
+      return registry ? registry->IsSolid(block) : block != 0;
+    }
+
+    // Chunk of the last lookup is kept by the caller, consecutive cells rarely cross chunk borders
+    bool IsSolidCell(const BlockRegistry* registry, glm::ivec3 cell, std::shared_ptr<const Chunk>& chunk, std::pair<int, int>& chunkPosition);
+    // Resident chunk with its occupancy, both nullptr when the chunk is not loaded
+    std::shared_ptr<const ChunkOccupancy> FindOccupancy(std::pair<int, int> position, std::shared_ptr<const Chunk>& chunk);
+
+    // Lights a chunk that just became resident and spreads light between it and its neighbours
+    void AttachLight(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk);
+    void UpdateLight(const std::vector<glm::ivec3>& cells);
+    void PublishLights(const std::vector<std::pair<std::pair<int, int>, std::shared_ptr<ChunkLight>>>& lights);
+    bool FindLitChunk(std::pair<int, int> position, std::shared_ptr<const Chunk>& chunk, std::shared_ptr<const ChunkLight>& light);
 
     std::shared_ptr<Chunk> GenerateChunk(std::pair<int, int> position);
   };
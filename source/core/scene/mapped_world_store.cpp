@@ -0,0 +1,414 @@
+#include "mapped_world_store.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <format>
+
+#include "io/file_api.hpp"
+#include "math_utils.hpp"
+
+
+namespace blocks
+{
+  MappedWorldStore::MappedWorldStore(std::string directory) : directory_(directory)
+  {
+    if (!blocks::isPathExist(directory_))
+    {
+      blocks::createDirectory(directory_);
+    }
+  }
+
+  MappedWorldStore::~MappedWorldStore()
+  {
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      // Last chance to save the newest versions, views that outlive the store see them
+      for (auto& [regionPosition, region] : regions_)
+      {
+        for (int i = 0; i < ChunksNumber; i++)
+        {
+          WritePendingChunk(region, i, true);
+        }
+      }
+    }
+
+    Flush();
+  }
+
+
+  const std::string& MappedWorldStore::GetDirectory() const
+  {
+    return directory_;
+  }
+
+
+  std::shared_ptr<const Chunk> MappedWorldStore::ReadChunk(std::pair<int, int> position, std::vector<ScheduledTick>* ticks)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    Region* region = OpenRegion(GetRegionPosition(position));
+    if (!region)
+    {
+      return nullptr;
+    }
+
+    int index = GetIndex(position);
+    const StoreHeader* header = (const StoreHeader*)region->file->GetData();
+    if (!header->storedChunks[index])
+    {
+      return nullptr;
+    }
+
+    if (ticks)
+    {
+      *ticks = region->ticks[index];
+    }
+
+    return GetView(*region, index);
+  }
+
+  std::shared_ptr<const Chunk> MappedWorldStore::WriteChunk(std::pair<int, int> position, const Chunk& chunk)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    Region* region = OpenRegion(GetRegionPosition(position));
+    if (!region)
+    {
+      return nullptr;
+    }
+
+    int index = GetIndex(position);
+    StoreHeader* header = (StoreHeader*)region->file->GetData();
+    if (!header->storedChunks[index])
+    {
+      memcpy(GetSlot(*region, index), &chunk, sizeof(Chunk));
+      header->storedChunks[index] = 1;
+    }
+
+    return GetView(*region, index);
+  }
+
+  bool MappedWorldStore::StoreChunk(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk, const std::vector<ScheduledTick>& ticks)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    Region* region = OpenRegion(GetRegionPosition(position));
+    if (!region)
+    {
+      return false;
+    }
+
+    int index = GetIndex(position);
+    StoreHeader* header = (StoreHeader*)region->file->GetData();
+    // Storing a view of the slot itself only drops a newer pending version
+    region->pendingChunks[index] = chunk.get() != GetSlot(*region, index) ? chunk : nullptr;
+    WritePendingChunk(*region, index);
+    header->storedChunks[index] = 1;
+
+    if (!ticks.empty() || !region->ticks[index].empty())
+    {
+      region->ticks[index] = ticks;
+      region->isTicksModified = true;
+    }
+
+    return true;
+  }
+
+
+  bool MappedWorldStore::Flush()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    // Ticks are written after the slots, a crash in between leaves updates that are dropped for blocks
+    // that do not tick anymore
+    bool result = true;
+    for (auto& [regionPosition, region] : regions_)
+    {
+      for (int i = 0; i < ChunksNumber; i++)
+      {
+        WritePendingChunk(region, i);
+      }
+
+      result = region.file->Flush() && result;
+      if (region.isTicksModified)
+      {
+        WriteTicks(regionPosition, region);
+      }
+    }
+
+    return result;
+  }
+
+  void MappedWorldStore::SetActiveArea(std::pair<int, int> center, int radius)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    auto isInside = [](std::pair<int, int> position, std::pair<int, int> areaCenter, int areaRadius)
+    {
+      return std::abs(position.first - areaCenter.first) <= areaRadius && std::abs(position.second - areaCenter.second) <= areaRadius;
+    };
+
+    if (activeRadius_ >= 0)
+    {
+      for (int x = activeCenter_.first - activeRadius_; x <= activeCenter_.first + activeRadius_; x++)
+      {
+        for (int y = activeCenter_.second - activeRadius_; y <= activeCenter_.second + activeRadius_; y++)
+        {
+          if (!isInside(std::make_pair(x, y), center, radius))
+          {
+            AdviseChunk(std::make_pair(x, y), MappingAdvice::DontNeed);
+          }
+        }
+      }
+    }
+
+    for (int x = center.first - radius; x <= center.first + radius; x++)
+    {
+      for (int y = center.second - radius; y <= center.second + radius; y++)
+      {
+        if (activeRadius_ < 0 || !isInside(std::make_pair(x, y), activeCenter_, activeRadius_))
+        {
+          AdviseChunk(std::make_pair(x, y), MappingAdvice::WillNeed);
+        }
+      }
+    }
+
+    activeCenter_ = center;
+    activeRadius_ = radius;
+
+    // A region of margin keeps the ones just left open for chunks evicted from the map
+    int margin = radius + RegionSize;
+    for (auto it = regions_.begin(); it != regions_.end();)
+    {
+      int minX = it->first.first * RegionSize;
+      int minY = it->first.second * RegionSize;
+      bool isNear = minX + RegionSize - 1 >= center.first - margin && minX <= center.first + margin &&
+        minY + RegionSize - 1 >= center.second - margin && minY <= center.second + margin;
+      if (isNear || !CloseRegion(it->first, it->second))
+      {
+        ++it;
+        continue;
+      }
+
+      it = regions_.erase(it);
+    }
+  }
+
+
+  MappedWorldStore::Region* MappedWorldStore::OpenRegion(std::pair<int, int> regionPosition)
+  {
+    auto it = regions_.find(regionPosition);
+    if (it != regions_.end())
+    {
+      return &it->second;
+    }
+
+    std::shared_ptr<WritableMappedFile> file = std::make_shared<WritableMappedFile>(directory_ + "/" + GetFileName(regionPosition), FileSize);
+    if (!file->IsOpen())
+    {
+      return nullptr;
+    }
+
+    StoreHeader* header = (StoreHeader*)file->GetData();
+    if (header->magic == 0)
+    {
+      // Fresh file is zero filled, every slot starts empty
+      header->magic = StoreHeader::Magic;
+      header->version = StoreHeader::Version;
+      header->regionSize = RegionSize;
+      header->chunkSize = sizeof(Chunk);
+    }
+    else if (header->magic != StoreHeader::Magic || header->version != StoreHeader::Version ||
+      header->regionSize != RegionSize || header->chunkSize != sizeof(Chunk))
+    {
+      return nullptr;
+    }
+
+    Region& region = regions_[regionPosition];
+    region.file = file;
+    ReadTicks(regionPosition, region);
+
+    return &region;
+  }
+
+  bool MappedWorldStore::CloseRegion(std::pair<int, int> regionPosition, Region& region)
+  {
+    // Versions waiting for readers keep the region open, views themselves keep only the mapping alive
+    for (int i = 0; i < ChunksNumber; i++)
+    {
+      WritePendingChunk(region, i);
+      if (region.pendingChunks[i])
+      {
+        return false;
+      }
+    }
+
+    if (!region.file->Flush())
+    {
+      return false;
+    }
+    if (region.isTicksModified)
+    {
+      WriteTicks(regionPosition, region);
+    }
+
+    return true;
+  }
+
+  std::shared_ptr<const Chunk> MappedWorldStore::GetView(Region& region, int index)
+  {
+    WritePendingChunk(region, index);
+    if (region.pendingChunks[index])
+    {
+      return region.pendingChunks[index];
+    }
+
+    // All readers share one view per slot, its own count tells when the slot may be rewritten
+    std::shared_ptr<const Chunk> view = region.views[index].lock();
+    if (!view)
+    {
+      view = std::shared_ptr<const Chunk>(GetSlot(region, index), [file = region.file](const Chunk*) {});
+      region.views[index] = view;
+    }
+
+    return view;
+  }
+
+  void MappedWorldStore::WritePendingChunk(Region& region, int index, bool isForced)
+  {
+    if (!region.pendingChunks[index] || (!isForced && region.views[index].lock()))
+    {
+      return;
+    }
+
+    memcpy(GetSlot(region, index), region.pendingChunks[index].get(), sizeof(Chunk));
+    region.pendingChunks[index] = nullptr;
+  }
+
+  void MappedWorldStore::ReadTicks(std::pair<int, int> regionPosition, Region& region)
+  {
+    std::string path = directory_ + "/" + GetTicksFileName(regionPosition);
+    if (!blocks::isPathExist(path))
+    {
+      return;
+    }
+
+    // A table that does not match is ignored as a whole, chunks then load without pending updates
+    std::vector<unsigned char> data = blocks::readBinaryFile(path);
+    if (data.size() < sizeof(TicksHeader))
+    {
+      return;
+    }
+
+    TicksHeader header;
+    memcpy(&header, data.data(), sizeof(TicksHeader));
+    if (header.magic != TicksHeader::Magic || header.version != TicksHeader::Version)
+    {
+      return;
+    }
+
+    size_t ticksNumber = 0;
+    for (int i = 0; i < ChunksNumber; i++)
+    {
+      ticksNumber += header.ticksNumbers[i];
+    }
+    if (data.size() != sizeof(TicksHeader) + ticksNumber * sizeof(ScheduledTick))
+    {
+      return;
+    }
+
+    const unsigned char* ticksData = data.data() + sizeof(TicksHeader);
+    for (int i = 0; i < ChunksNumber; i++)
+    {
+      if (header.ticksNumbers[i] == 0)
+      {
+        continue;
+      }
+      region.ticks[i].resize(header.ticksNumbers[i]);
+      memcpy(region.ticks[i].data(), ticksData, header.ticksNumbers[i] * sizeof(ScheduledTick));
+      ticksData += header.ticksNumbers[i] * sizeof(ScheduledTick);
+    }
+  }
+
+  void MappedWorldStore::WriteTicks(std::pair<int, int> regionPosition, Region& region)
+  {
+    TicksHeader header = {};
+    header.magic = TicksHeader::Magic;
+    header.version = TicksHeader::Version;
+
+    size_t ticksNumber = 0;
+    for (int i = 0; i < ChunksNumber; i++)
+    {
+      header.ticksNumbers[i] = (std::uint32_t)region.ticks[i].size();
+      ticksNumber += region.ticks[i].size();
+    }
+
+    std::vector<unsigned char> data(sizeof(TicksHeader) + ticksNumber * sizeof(ScheduledTick));
+    memcpy(data.data(), &header, sizeof(TicksHeader));
+
+    unsigned char* ticksData = data.data() + sizeof(TicksHeader);
+    for (int i = 0; i < ChunksNumber; i++)
+    {
+      if (region.ticks[i].empty())
+      {
+        continue;
+      }
+      memcpy(ticksData, region.ticks[i].data(), region.ticks[i].size() * sizeof(ScheduledTick));
+      ticksData += region.ticks[i].size() * sizeof(ScheduledTick);
+    }
+
+    blocks::saveBinaryFile(directory_ + "/" + GetTicksFileName(regionPosition), std::move(data));
+    region.isTicksModified = false;
+  }
+
+  void MappedWorldStore::AdviseChunk(std::pair<int, int> position, MappingAdvice advice)
+  {
+    // Prefetch may map existing regions, but advice never creates new files
+    std::pair<int, int> regionPosition = GetRegionPosition(position);
+    Region* region = nullptr;
+
+    auto it = regions_.find(regionPosition);
+    if (it != regions_.end())
+    {
+      region = &it->second;
+    }
+    else if (advice == MappingAdvice::WillNeed && blocks::isPathExist(directory_ + "/" + GetFileName(regionPosition)))
+    {
+      region = OpenRegion(regionPosition);
+    }
+
+    if (region)
+    {
+      region->file->Advise(HeaderSize + GetIndex(position) * sizeof(Chunk), sizeof(Chunk), advice);
+    }
+  }
+
+
+  std::pair<int, int> MappedWorldStore::GetRegionPosition(std::pair<int, int> chunkPosition)
+  {
+    return std::make_pair(floorDivide(chunkPosition.first, RegionSize), floorDivide(chunkPosition.second, RegionSize));
+  }
+
+  int MappedWorldStore::GetIndex(std::pair<int, int> chunkPosition)
+  {
+    std::pair<int, int> regionPosition = GetRegionPosition(chunkPosition);
+
+    return (chunkPosition.first - regionPosition.first * RegionSize) + (chunkPosition.second - regionPosition.second * RegionSize) * RegionSize;
+  }
+
+  Chunk* MappedWorldStore::GetSlot(const Region& region, int index)
+  {
+    return (Chunk*)(region.file->GetData() + HeaderSize + index * sizeof(Chunk));
+  }
+
+  std::string MappedWorldStore::GetFileName(std::pair<int, int> regionPosition)
+  {
+    return std::format("m.{0}.{1}.chunks", regionPosition.first, regionPosition.second);
+  }
+
+  std::string MappedWorldStore::GetTicksFileName(std::pair<int, int> regionPosition)
+  {
+    return std::format("m.{0}.{1}.ticks", regionPosition.first, regionPosition.second);
+  }
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chunk.hpp"
+#include "chunk_codec.hpp"
+#include "io/writable_mapped_file.hpp"
+
+
+namespace blocks
+{
+  // Uncompressed world kept in memory-mapped files of RegionSize x RegionSize chunk slots.
+  // Loaded chunks are views straight into the page cache. A slot is only rewritten once nobody holds
+  // a view of it, until then the stored version stays pending in memory. Pending block ticks are small
+  // and go to a side table per region, rewritten as a whole on flush.
+  class MappedWorldStore
+  {
+  public:
+    static const int RegionSize = 8;
+    static const int ChunksNumber = RegionSize * RegionSize;
+    static constexpr size_t HeaderSize = 4096;
+    static constexpr size_t FileSize = HeaderSize + ChunksNumber * sizeof(Chunk);
+
+    MappedWorldStore(std::string directory);
+    MappedWorldStore(const MappedWorldStore&) = delete;
+    MappedWorldStore(MappedWorldStore&& other) = delete;
+    MappedWorldStore& operator=(const MappedWorldStore&) = delete;
+    MappedWorldStore& operator=(MappedWorldStore&& other) = delete;
+    ~MappedWorldStore();
+
+    const std::string& GetDirectory() const;
+
+    // Returns nullptr when the chunk was never stored
+    std::shared_ptr<const Chunk> ReadChunk(std::pair<int, int> position, std::vector<ScheduledTick>* ticks = nullptr);
+    // Copies the chunk into its slot unless another one got there first, returns the stored chunk
+    std::shared_ptr<const Chunk> WriteChunk(std::pair<int, int> position, const Chunk& chunk);
+    // Replaces the stored chunk with an edited version, chunks returned before keep the old blocks
+    bool StoreChunk(std::pair<int, int> position, std::shared_ptr<const Chunk> chunk, const std::vector<ScheduledTick>& ticks = {});
+
+    // Slots still viewed by readers keep their pending version until a later flush
+    bool Flush();
+    // Prefetches chunks around center, lets the kernel drop chunks that left the previous area
+    // and closes regions more than a region away from the new one
+    void SetActiveArea(std::pair<int, int> center, int radius);
+
+  private:
+    struct StoreHeader
+    {
+      static const std::uint32_t Magic = 0x50414D42; // "BMAP"
+      static const std::uint32_t Version = 1;
+
+      std::uint32_t magic;
+      std::uint32_t version;
+      std::uint32_t regionSize;
+      std::uint32_t chunkSize;
+      std::uint8_t storedChunks[ChunksNumber];
+    };
+
+    static_assert(sizeof(StoreHeader) <= HeaderSize);
+
+    // Tick counts of every slot followed by all (index, delay) pairs in slot order
+    struct TicksHeader
+    {
+      static const std::uint32_t Magic = 0x4B435442; // "BTCK"
+      static const std::uint32_t Version = 1;
+
+      std::uint32_t magic;
+      std::uint32_t version;
+      std::uint32_t ticksNumbers[ChunksNumber];
+    };
+
+    struct Region
+    {
+      std::shared_ptr<WritableMappedFile> file;
+      std::vector<ScheduledTick> ticks[ChunksNumber];
+      std::weak_ptr<const Chunk> views[ChunksNumber];
+      std::shared_ptr<const Chunk> pendingChunks[ChunksNumber];
+      bool isTicksModified = false;
+    };
+
+    Region* OpenRegion(std::pair<int, int> regionPosition);
+    bool CloseRegion(std::pair<int, int> regionPosition, Region& region);
+    std::shared_ptr<const Chunk> GetView(Region& region, int index);
+    void WritePendingChunk(Region& region, int index, bool isForced = false);
+    void ReadTicks(std::pair<int, int> regionPosition, Region& region);
+    void WriteTicks(std::pair<int, int> regionPosition, Region& region);
+    void AdviseChunk(std::pair<int, int> position, MappingAdvice advice);
+
+    static std::pair<int, int> GetRegionPosition(std::pair<int, int> chunkPosition);
+    static int GetIndex(std::pair<int, int> chunkPosition);
+    static Chunk* GetSlot(const Region& region, int index);
+    static std::string GetFileName(std::pair<int, int> regionPosition);
+    static std::string GetTicksFileName(std::pair<int, int> regionPosition);
+
+    std::string directory_;
+    std::map<std::pair<int, int>, Region> regions_;
+    std::pair<int, int> activeCenter_ = std::make_pair(0, 0);
+    int activeRadius_ = -1;
+    std::mutex mutex_;
+  };
+}
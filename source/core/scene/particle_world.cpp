@@ -0,0 +1,370 @@
+#include "particle_world.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "math_utils.hpp"
+#include "simd_config.hpp"
+
+
+namespace blocks
+{
+  namespace
+  {
+    const float Gravity = 20.0f;
+    const float GroundFriction = 8.0f;
+    // Share of the speed kept after a bounce
+    const float Restitution = 0.3f;
+    // Particles falling out of the world are removed
+    const float MinHeight = -64.0f;
+  }
+
+
+  ParticleWorld::ParticleWorld()
+  {
+
+  }
+
+
+  void ParticleWorld::Emit(ParticleEffect effect, glm::vec3 center, size_t particlesNumber, float texture, std::uint8_t light)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    particlesNumber = std::min(particlesNumber, MaxParticlesNumber - positionX_.size());
+
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> share(0.0f, 1.0f);
+    for (size_t i = 0; i < particlesNumber; i++)
+    {
+      glm::vec3 offset = glm::vec3(unit(random_), unit(random_), unit(random_));
+      glm::vec3 position;
+      glm::vec3 velocity;
+      float gravity;
+      float life;
+      float size;
+      switch (effect)
+      {
+      case ParticleEffect::Debris:
+        // Chips thrown up out of the broken block
+        position = center + offset * 0.4f;
+        velocity = glm::vec3(offset.x * 2.5f, offset.y * 2.5f, 2.0f + share(random_) * 3.0f);
+        gravity = Gravity;
+        life = 1.0f + share(random_);
+        size = 0.08f + share(random_) * 0.08f;
+        break;
+      case ParticleEffect::Dust:
+      default:
+        // Slowly drifting puffs that barely fall
+        position = center + offset * 0.5f;
+        velocity = glm::vec3(offset.x * 0.5f, offset.y * 0.5f, share(random_));
+        gravity = Gravity * 0.05f;
+        life = 0.5f + share(random_) * 0.7f;
+        size = 0.2f + share(random_) * 0.15f;
+        break;
+      }
+
+      positionX_.push_back(position.x);
+      positionY_.push_back(position.y);
+      positionZ_.push_back(position.z);
+      velocityX_.push_back(velocity.x);
+      velocityY_.push_back(velocity.y);
+      velocityZ_.push_back(velocity.z);
+      gravity_.push_back(gravity);
+      life_.push_back(life);
+      sizes_.push_back(size);
+      textures_.push_back(texture);
+      lights_.push_back((float)std::max(ChunkLight::GetSkyLevel(light), ChunkLight::GetBlockLevel(light)));
+    }
+  }
+
+  size_t ParticleWorld::GetParticlesNumber()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return positionX_.size();
+  }
+
+
+  void ParticleWorld::Update(float delta, Map& map)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    // One empty publish after the last particle died clears the render side
+    if (positionX_.empty() && publishedNumber_ == 0)
+    {
+      return;
+    }
+
+    size_t size = positionX_.size();
+    nextX_.resize(size);
+    nextY_.resize(size);
+    nextZ_.resize(size);
+    blockedVertical_.resize(size);
+    blockedHorizontal_.resize(size);
+
+    Integrate(delta);
+    FindCollisions(map);
+    ResolveCollisions(delta);
+    RemoveDead();
+    PublishInstances();
+  }
+
+  bool ParticleWorld::TakeInstances(std::vector<ParticleInstance>& instances)
+  {
+    std::lock_guard<std::mutex> locker(instancesMutex_);
+
+    if (!isInstancesChanged_)
+    {
+      return false;
+    }
+
+    std::swap(instances, instances_);
+    isInstancesChanged_ = false;
+    return true;
+  }
+
+
+  void ParticleWorld::Integrate(float delta)
+  {
+    size_t size = positionX_.size();
+    size_t i = 0;
+
+#if defined(BLOCKS_SIMD_AVX2)
+    __m256 step = _mm256_set1_ps(delta);
+    for (; i + 8 <= size; i += 8)
+    {
+      __m256 velocityX = _mm256_load_ps(&velocityX_[i]);
+      __m256 velocityY = _mm256_load_ps(&velocityY_[i]);
+      __m256 velocityZ = _mm256_sub_ps(_mm256_load_ps(&velocityZ_[i]), _mm256_mul_ps(_mm256_load_ps(&gravity_[i]), step));
+
+      _mm256_store_ps(&velocityZ_[i], velocityZ);
+      _mm256_store_ps(&nextX_[i], _mm256_add_ps(_mm256_load_ps(&positionX_[i]), _mm256_mul_ps(velocityX, step)));
+      _mm256_store_ps(&nextY_[i], _mm256_add_ps(_mm256_load_ps(&positionY_[i]), _mm256_mul_ps(velocityY, step)));
+      _mm256_store_ps(&nextZ_[i], _mm256_add_ps(_mm256_load_ps(&positionZ_[i]), _mm256_mul_ps(velocityZ, step)));
+      _mm256_store_ps(&life_[i], _mm256_sub_ps(_mm256_load_ps(&life_[i]), step));
+    }
+#elif defined(BLOCKS_SIMD_SSE)
+    __m128 step = _mm_set1_ps(delta);
+    for (; i + 4 <= size; i += 4)
+    {
+      __m128 velocityX = _mm_load_ps(&velocityX_[i]);
+      __m128 velocityY = _mm_load_ps(&velocityY_[i]);
+      __m128 velocityZ = _mm_sub_ps(_mm_load_ps(&velocityZ_[i]), _mm_mul_ps(_mm_load_ps(&gravity_[i]), step));
+
+      _mm_store_ps(&velocityZ_[i], velocityZ);
+      _mm_store_ps(&nextX_[i], _mm_add_ps(_mm_load_ps(&positionX_[i]), _mm_mul_ps(velocityX, step)));
+      _mm_store_ps(&nextY_[i], _mm_add_ps(_mm_load_ps(&positionY_[i]), _mm_mul_ps(velocityY, step)));
+      _mm_store_ps(&nextZ_[i], _mm_add_ps(_mm_load_ps(&positionZ_[i]), _mm_mul_ps(velocityZ, step)));
+      _mm_store_ps(&life_[i], _mm_sub_ps(_mm_load_ps(&life_[i]), step));
+    }
+#endif
+
+    // Scalar tail, or everything when no SIMD is available
+    for (; i < size; i++)
+    {
+      velocityZ_[i] -= gravity_[i] * delta;
+      nextX_[i] = positionX_[i] + velocityX_[i] * delta;
+      nextY_[i] = positionY_[i] + velocityY_[i] * delta;
+      nextZ_[i] = positionZ_[i] + velocityZ_[i] * delta;
+      life_[i] -= delta;
+    }
+  }
+
+  void ParticleWorld::FindCollisions(Map& map)
+  {
+    std::shared_ptr<const BlockRegistry> registry = map.GetBlockRegistry();
+
+    // Particles of one burst are stored next to each other, so the last chunk is usually the right one
+    std::pair<int, int> chunkPosition;
+    std::shared_ptr<const Chunk> chunk = nullptr;
+    bool isChunkKnown = false;
+    auto isSolid = [&](glm::ivec3 cell)
+    {
+      if (cell.z < 0 || cell.z >= (int)Chunk::Height)
+      {
+        return false;
+      }
+
+      std::pair<int, int> cellChunkPosition = std::make_pair(floorDivide(cell.x, Chunk::Length), floorDivide(cell.y, Chunk::Width));
+      if (!isChunkKnown || cellChunkPosition != chunkPosition)
+      {
+        chunk = map.FindChunk(cellChunkPosition);
+        chunkPosition = cellChunkPosition;
+        isChunkKnown = true;
+      }
+
+      // Chunks that are not loaded hold particles in place until they expire
+      if (!chunk)
+      {
+        return true;
+      }
+
+      int x = cell.x - chunkPosition.first * (int)Chunk::Length;
+      int y = cell.y - chunkPosition.second * (int)Chunk::Width;
+      Block block = chunk->blocks[x + y * Chunk::Width + cell.z * Chunk::LayerBlocksNumber];
+      return registry ? registry->IsSolid(block) : block != 0;
+    };
+
+    // Vertical move is checked first, the horizontal one from where it ended, so the final cell is always tested
+    size_t size = positionX_.size();
+    for (size_t i = 0; i < size; i++)
+    {
+      glm::ivec3 cell = glm::ivec3((int)std::floor(positionX_[i]), (int)std::floor(positionY_[i]), (int)std::floor(positionZ_[i]));
+      glm::ivec3 nextCell = glm::ivec3((int)std::floor(nextX_[i]), (int)std::floor(nextY_[i]), (int)std::floor(nextZ_[i]));
+
+      bool isVerticalBlocked = nextCell.z != cell.z && isSolid(glm::ivec3(cell.x, cell.y, nextCell.z));
+      glm::ivec3 horizontalCell = glm::ivec3(nextCell.x, nextCell.y, isVerticalBlocked ? cell.z : nextCell.z);
+      bool isHorizontalBlocked = (horizontalCell.x != cell.x || horizontalCell.y != cell.y) && isSolid(horizontalCell);
+
+      blockedVertical_[i] = isVerticalBlocked ? -1 : 0;
+      blockedHorizontal_[i] = isHorizontalBlocked ? -1 : 0;
+    }
+  }
+
+  void ParticleWorld::ResolveCollisions(float delta)
+  {
+    float friction = std::max(1.0f - GroundFriction * delta, 0.0f);
+    size_t size = positionX_.size();
+    size_t i = 0;
+
+#if defined(BLOCKS_SIMD_AVX2)
+    __m256 bounce = _mm256_set1_ps(-Restitution);
+    __m256 groundFriction = _mm256_set1_ps(friction);
+    __m256 one = _mm256_set1_ps(1.0f);
+    for (; i + 8 <= size; i += 8)
+    {
+      __m256 vertical = _mm256_castsi256_ps(_mm256_load_si256((const __m256i*)&blockedVertical_[i]));
+      __m256 horizontal = _mm256_castsi256_ps(_mm256_load_si256((const __m256i*)&blockedHorizontal_[i]));
+
+      // Landing slows the particle down along the ground, hitting a wall bounces it back
+      __m256 velocityZ = _mm256_load_ps(&velocityZ_[i]);
+      __m256 velocityScale = _mm256_blendv_ps(one, groundFriction, vertical);
+      velocityScale = _mm256_blendv_ps(velocityScale, _mm256_mul_ps(velocityScale, bounce), horizontal);
+      __m256 velocityX = _mm256_mul_ps(_mm256_load_ps(&velocityX_[i]), velocityScale);
+      __m256 velocityY = _mm256_mul_ps(_mm256_load_ps(&velocityY_[i]), velocityScale);
+
+      _mm256_store_ps(&velocityX_[i], velocityX);
+      _mm256_store_ps(&velocityY_[i], velocityY);
+      _mm256_store_ps(&velocityZ_[i], _mm256_blendv_ps(velocityZ, _mm256_mul_ps(velocityZ, bounce), vertical));
+      _mm256_store_ps(&positionX_[i], _mm256_blendv_ps(_mm256_load_ps(&nextX_[i]), _mm256_load_ps(&positionX_[i]), horizontal));
+      _mm256_store_ps(&positionY_[i], _mm256_blendv_ps(_mm256_load_ps(&nextY_[i]), _mm256_load_ps(&positionY_[i]), horizontal));
+      _mm256_store_ps(&positionZ_[i], _mm256_blendv_ps(_mm256_load_ps(&nextZ_[i]), _mm256_load_ps(&positionZ_[i]), vertical));
+    }
+#elif defined(BLOCKS_SIMD_SSE)
+    __m128 bounce = _mm_set1_ps(-Restitution);
+    __m128 groundFriction = _mm_set1_ps(friction);
+    __m128 one = _mm_set1_ps(1.0f);
+    // No blend before SSE4.1, select through the masks
+    auto select = [](__m128 mask, __m128 blocked, __m128 free) { return _mm_or_ps(_mm_and_ps(mask, blocked), _mm_andnot_ps(mask, free)); };
+    for (; i + 4 <= size; i += 4)
+    {
+      __m128 vertical = _mm_castsi128_ps(_mm_load_si128((const __m128i*)&blockedVertical_[i]));
+      __m128 horizontal = _mm_castsi128_ps(_mm_load_si128((const __m128i*)&blockedHorizontal_[i]));
+
+      // Landing slows the particle down along the ground, hitting a wall bounces it back
+      __m128 velocityZ = _mm_load_ps(&velocityZ_[i]);
+      __m128 velocityScale = select(vertical, groundFriction, one);
+      velocityScale = select(horizontal, _mm_mul_ps(velocityScale, bounce), velocityScale);
+      __m128 velocityX = _mm_mul_ps(_mm_load_ps(&velocityX_[i]), velocityScale);
+      __m128 velocityY = _mm_mul_ps(_mm_load_ps(&velocityY_[i]), velocityScale);
+
+      _mm_store_ps(&velocityX_[i], velocityX);
+      _mm_store_ps(&velocityY_[i], velocityY);
+      _mm_store_ps(&velocityZ_[i], select(vertical, _mm_mul_ps(velocityZ, bounce), velocityZ));
+      _mm_store_ps(&positionX_[i], select(horizontal, _mm_load_ps(&positionX_[i]), _mm_load_ps(&nextX_[i])));
+      _mm_store_ps(&positionY_[i], select(horizontal, _mm_load_ps(&positionY_[i]), _mm_load_ps(&nextY_[i])));
+      _mm_store_ps(&positionZ_[i], select(vertical, _mm_load_ps(&positionZ_[i]), _mm_load_ps(&nextZ_[i])));
+    }
+#endif
+
+    // Scalar tail, or everything when no SIMD is available
+    for (; i < size; i++)
+    {
+      bool isVerticalBlocked = blockedVertical_[i] != 0;
+      bool isHorizontalBlocked = blockedHorizontal_[i] != 0;
+
+      float velocityScale = isVerticalBlocked ? friction : 1.0f;
+      velocityScale *= isHorizontalBlocked ? -Restitution : 1.0f;
+      velocityX_[i] *= velocityScale;
+      velocityY_[i] *= velocityScale;
+      velocityZ_[i] *= isVerticalBlocked ? -Restitution : 1.0f;
+
+      if (!isHorizontalBlocked)
+      {
+        positionX_[i] = nextX_[i];
+        positionY_[i] = nextY_[i];
+      }
+      if (!isVerticalBlocked)
+      {
+        positionZ_[i] = nextZ_[i];
+      }
+    }
+  }
+
+  void ParticleWorld::RemoveDead()
+  {
+    for (size_t i = 0; i < positionX_.size(); )
+    {
+      if (life_[i] <= 0.0f || positionZ_[i] < MinHeight)
+      {
+        RemoveAt(i);
+      }
+      else
+      {
+        i++;
+      }
+    }
+  }
+
+  void ParticleWorld::PublishInstances()
+  {
+    size_t size = positionX_.size();
+    builtInstances_.resize(size);
+    for (size_t i = 0; i < size; i++)
+    {
+      ParticleInstance& instance = builtInstances_[i];
+      instance.position = glm::vec3(positionX_[i], positionY_[i], positionZ_[i]);
+      instance.size = sizes_[i];
+      instance.texture = textures_[i];
+      instance.light = lights_[i];
+    }
+
+    publishedNumber_ = size;
+
+    std::lock_guard<std::mutex> locker(instancesMutex_);
+
+    std::swap(builtInstances_, instances_);
+    isInstancesChanged_ = true;
+  }
+
+  void ParticleWorld::RemoveAt(size_t index)
+  {
+    size_t last = positionX_.size() - 1;
+    if (index != last)
+    {
+      positionX_[index] = positionX_[last];
+      positionY_[index] = positionY_[last];
+      positionZ_[index] = positionZ_[last];
+      velocityX_[index] = velocityX_[last];
+      velocityY_[index] = velocityY_[last];
+      velocityZ_[index] = velocityZ_[last];
+      gravity_[index] = gravity_[last];
+      life_[index] = life_[last];
+      sizes_[index] = sizes_[last];
+      textures_[index] = textures_[last];
+      lights_[index] = lights_[last];
+    }
+
+    positionX_.pop_back();
+    positionY_.pop_back();
+    positionZ_.pop_back();
+    velocityX_.pop_back();
+    velocityY_.pop_back();
+    velocityZ_.pop_back();
+    gravity_.pop_back();
+    life_.pop_back();
+    sizes_.pop_back();
+    textures_.pop_back();
+    lights_.pop_back();
+  }
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "map.hpp"
+#include "memory/aligned_allocator.hpp"
+
+
+namespace blocks
+{
+  enum class ParticleEffect : std::uint8_t
+  {
+    Debris,
+    Dust
+  };
+
+  // Per particle data of the instanced billboards
+  struct ParticleInstance
+  {
+    glm::vec3 position;
+    float size;
+    float texture;
+    // Light level of the cell the particle was emitted in
+    float light;
+  };
+
+  // Short lived visual particles kept as structure of arrays streams. Integration and collision response run
+  // over whole streams with SIMD, only the solid lookup of the cells is done one particle at a time.
+  // Dead particles are swapped with the last one, so the streams stay dense.
+  class ParticleWorld
+  {
+  public:
+    static const size_t MaxParticlesNumber = 1 << 17;
+
+    ParticleWorld();
+    ParticleWorld(const ParticleWorld&) = delete;
+    ParticleWorld(ParticleWorld&& other) = delete;
+    ParticleWorld& operator=(const ParticleWorld&) = delete;
+    ParticleWorld& operator=(ParticleWorld&& other) = delete;
+
+    // Particles over the limit are dropped
+    void Emit(ParticleEffect effect, glm::vec3 center, size_t particlesNumber, float texture, std::uint8_t light);
+    size_t GetParticlesNumber();
+
+    void Update(float delta, Map& map);
+    // Swaps in the particles published by the last update, returns false when nothing changed since the last call
+    bool TakeInstances(std::vector<ParticleInstance>& instances);
+
+  private:
+    void Integrate(float delta);
+    void FindCollisions(Map& map);
+    void ResolveCollisions(float delta);
+    void RemoveDead();
+    void PublishInstances();
+    void RemoveAt(size_t index);
+
+    std::vector<float, AlignedAllocator<float>> positionX_;
+    std::vector<float, AlignedAllocator<float>> positionY_;
+    std::vector<float, AlignedAllocator<float>> positionZ_;
+    std::vector<float, AlignedAllocator<float>> velocityX_;
+    std::vector<float, AlignedAllocator<float>> velocityY_;
+    std::vector<float, AlignedAllocator<float>> velocityZ_;
+    std::vector<float, AlignedAllocator<float>> gravity_;
+    std::vector<float, AlignedAllocator<float>> life_;
+    std::vector<float> sizes_;
+    std::vector<float> textures_;
+    std::vector<float> lights_;
+
+    // Positions after the integration step, the current ones are kept to step back on collisions
+    std::vector<float, AlignedAllocator<float>> nextX_;
+    std::vector<float, AlignedAllocator<float>> nextY_;
+    std::vector<float, AlignedAllocator<float>> nextZ_;
+    // All bits set for blocked particles, used as SIMD select masks
+    std::vector<std::int32_t, AlignedAllocator<std::int32_t>> blockedVertical_;
+    std::vector<std::int32_t, AlignedAllocator<std::int32_t>> blockedHorizontal_;
+
+    std::vector<ParticleInstance> builtInstances_;
+    size_t publishedNumber_ = 0;
+    std::vector<ParticleInstance> instances_;
+    bool isInstancesChanged_ = false;
+
+    std::mt19937 random_;
+    std::mutex mutex_;
+    // Guards published instances only, the render thread never waits for a whole update
+    std::mutex instancesMutex_;
+  };
+}
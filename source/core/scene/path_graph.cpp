@@ -0,0 +1,621 @@
+#include "path_graph.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <queue>
+
+#include "math_utils.hpp"
+
+
+namespace blocks
+{
+  namespace
+  {
+    const glm::ivec3 SideNeighbours[4] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 } };
+    const glm::ivec3 Up = glm::ivec3(0, 0, 1);
+
+    std::pair<int, int> GetChunkPosition(glm::ivec3 cell)
+    {
+      return std::make_pair(floorDivide(cell.x, Chunk::Length), floorDivide(cell.y, Chunk::Width));
+    }
+
+    // 24 bits for x and y, 16 for z
+    std::uint64_t GetCellKey(glm::ivec3 cell)
+    {
+      return ((std::uint64_t)(cell.x & 0xFFFFFF) << 40) | ((std::uint64_t)(cell.y & 0xFFFFFF) << 16) | (std::uint64_t)(cell.z & 0xFFFF);
+    }
+
+    glm::ivec3 GetKeyCell(std::uint64_t key)
+    {
+      // Shifts up and back down to restore the signs
+      int x = (int)((std::int64_t)key >> 40);
+      int y = (int)((std::int64_t)(key << 24) >> 40);
+      int z = (int)(key & 0xFFFF);
+      return glm::ivec3(x, y, z);
+    }
+
+    std::uint32_t GetEstimate(glm::ivec3 from, glm::ivec3 to)
+    {
+      // Every step moves one cell sideways, so the flat distance never overestimates
+      return (std::uint32_t)(std::abs(to.x - from.x) + std::abs(to.y - from.y));
+    }
+  }
+
+
+  // Block grid as the agent sees it, chunks are looked up once per search
+  class PathGraph::GridView
+  {
+  public:
+    GridView(Map& map) : map_(map), registry_(map.GetBlockRegistry())
+    {
+
+    }
+
+    bool IsResident(std::pair<int, int> position)
+    {
+      return GetChunk(position) != nullptr;
+    }
+
+    // Cells of chunks that are not resident are solid
+    bool IsSolid(glm::ivec3 cell)
+    {
+      if (cell.z < 0)
+      {
+        return true;
+      }
+      if (cell.z >= (int)Chunk::Height)
+      {
+        return false;
+      }
+
+      std::pair<int, int> position = GetChunkPosition(cell);
+      const Chunk* chunk = GetChunk(position);
+      if (!chunk)
+      {
+        return true;
+      }
+
+      Block block = chunk->blocks[(cell.x - position.first * (int)Chunk::Length) + (cell.y - position.second * (int)Chunk::Width) * Chunk::Width + cell.z * Chunk::LayerBlocksNumber];
+      return registry_ ? registry_->IsSolid(block) : block != 0;
+    }
+
+    bool IsWalkable(glm::ivec3 cell)
+    {
+      if (!IsSolid(cell - Up))
+      {
+        return false;
+      }
+
+      for (int i = 0; i < AgentHeight; i++)
+      {
+        if (IsSolid(cell + Up * i))
+        {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    // Steps one cell sideways and at most one up or down, the agent needs head room on the higher column
+    bool CanStep(glm::ivec3 from, glm::ivec3 to)
+    {
+      if (!IsWalkable(to))
+      {
+        return false;
+      }
+
+      if (to.z > from.z)
+      {
+        return !IsSolid(from + Up * AgentHeight);
+      }
+      if (to.z < from.z)
+      {
+        return !IsSolid(to + Up * AgentHeight);
+      }
+
+      return true;
+    }
+
+    template<typename Visitor>
+    void ForEachStep(glm::ivec3 cell, Visitor visit)
+    {
+      for (const glm::ivec3& side : SideNeighbours)
+      {
+        for (int dz = -1; dz <= 1; dz++)
+        {
+          glm::ivec3 next = cell + side + Up * dz;
+          if (CanStep(cell, next))
+          {
+            visit(next);
+          }
+        }
+      }
+    }
+
+  private:
+    const Chunk* GetChunk(std::pair<int, int> position)
+    {
+      if (lastChunk_ && position == lastPosition_)
+      {
+        return lastChunk_;
+      }
+
+      auto it = chunks_.find(position);
+      if (it == chunks_.end())
+      {
+        it = chunks_.emplace(position, map_.FindChunk(position)).first;
+      }
+
+      lastPosition_ = position;
+      lastChunk_ = it->second.get();
+      return lastChunk_;
+    }
+
+    Map& map_;
+    std::shared_ptr<const BlockRegistry> registry_;
+    // Versions are pinned for the whole search, so it sees a consistent world
+    std::map<std::pair<int, int>, std::shared_ptr<const Chunk>> chunks_;
+    std::pair<int, int> lastPosition_;
+    const Chunk* lastChunk_ = nullptr;
+  };
+
+
+  template<typename Visitor>
+  void PathGraph::WalkChunk(GridView& view, glm::ivec3 start, std::unordered_map<std::uint64_t, std::uint64_t>& parents, Visitor visit)
+  {
+    std::pair<int, int> position = GetChunkPosition(start);
+
+    std::deque<std::pair<glm::ivec3, std::uint32_t>> queue;
+    parents[GetCellKey(start)] = GetCellKey(start);
+    queue.push_back(std::make_pair(start, 0));
+    while (!queue.empty())
+    {
+      auto [cell, distance] = queue.front();
+      queue.pop_front();
+
+      if (visit(cell, distance))
+      {
+        return;
+      }
+
+      view.ForEachStep(cell, [&](glm::ivec3 next)
+        {
+          if (GetChunkPosition(next) == position && parents.emplace(GetCellKey(next), GetCellKey(cell)).second)
+          {
+            queue.push_back(std::make_pair(next, distance + 1));
+          }
+        });
+    }
+  }
+
+  std::vector<glm::ivec3> PathGraph::FindLocalPath(GridView& view, glm::ivec3 start, glm::ivec3 goal)
+  {
+    std::unordered_map<std::uint64_t, std::uint64_t> parents;
+    bool isFound = false;
+    WalkChunk(view, start, parents, [&](glm::ivec3 cell, std::uint32_t) { return isFound = cell == goal; });
+    if (!isFound)
+    {
+      return {};
+    }
+
+    std::vector<glm::ivec3> path;
+    for (std::uint64_t key = GetCellKey(goal); ; key = parents[key])
+    {
+      path.push_back(GetKeyCell(key));
+      if (key == parents[key])
+      {
+        break;
+      }
+    }
+    std::reverse(path.begin(), path.end());
+
+    return path;
+  }
+
+
+  PathGraph::PathGraph()
+  {
+
+  }
+
+
+  std::vector<glm::ivec3> PathGraph::FindPath(Map& map, glm::ivec3 start, glm::ivec3 goal, size_t searchLimit)
+  {
+    GridView view(map);
+    if (!view.IsWalkable(start) || !view.IsWalkable(goal))
+    {
+      return {};
+    }
+
+    std::pair<int, int> goalChunk = GetChunkPosition(goal);
+    if (GetChunkPosition(start) == goalChunk)
+    {
+      std::vector<glm::ivec3> path = FindLocalPath(view, start, goal);
+      if (!path.empty())
+      {
+        return path;
+      }
+    }
+
+    std::map<std::pair<int, int>, std::shared_ptr<const ChunkGraph>> graphs;
+    auto getGraph = [&](std::pair<int, int> position)
+      {
+        auto it = graphs.find(position);
+        if (it == graphs.end())
+        {
+          it = graphs.emplace(position, GetChunkGraph(view, position)).first;
+        }
+        return it->second.get();
+      };
+
+    const ChunkGraph* startGraph = getGraph(GetChunkPosition(start));
+    const ChunkGraph* goalGraph = getGraph(goalChunk);
+    if (!startGraph || !goalGraph)
+    {
+      return {};
+    }
+
+    // Endpoints join the portal graph with their walking distances to the portals of their chunks
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> startEdges;
+    std::unordered_map<std::uint64_t, std::uint64_t> parents;
+    WalkChunk(view, start, parents, [&](glm::ivec3 cell, std::uint32_t distance)
+      {
+        if (startGraph->indices.contains(GetCellKey(cell)))
+        {
+          startEdges.emplace_back(GetCellKey(cell), distance);
+        }
+        return false;
+      });
+
+    std::unordered_map<std::uint64_t, std::uint32_t> goalEdges;
+    parents.clear();
+    WalkChunk(view, goal, parents, [&](glm::ivec3 cell, std::uint32_t distance)
+      {
+        if (goalGraph->indices.contains(GetCellKey(cell)))
+        {
+          goalEdges.emplace(GetCellKey(cell), distance);
+        }
+        return false;
+      });
+
+    std::uint64_t startKey = GetCellKey(start);
+    std::uint64_t goalKey = GetCellKey(goal);
+
+    typedef std::pair<std::uint32_t, std::uint64_t> OpenEntry;
+    std::priority_queue<OpenEntry, std::vector<OpenEntry>, std::greater<OpenEntry>> open;
+    std::unordered_map<std::uint64_t, std::uint32_t> costs;
+    parents.clear();
+
+    costs[startKey] = 0;
+    parents[startKey] = startKey;
+    open.push(std::make_pair(GetEstimate(start, goal), startKey));
+
+    size_t expansionsNumber = 0;
+    bool isFound = false;
+    while (!open.empty() && expansionsNumber < searchLimit)
+    {
+      auto [estimate, key] = open.top();
+      open.pop();
+
+      glm::ivec3 cell = GetKeyCell(key);
+      std::uint32_t cost = costs[key];
+      if (estimate > cost + GetEstimate(cell, goal))
+      {
+        continue;
+      }
+      if (key == goalKey)
+      {
+        isFound = true;
+        break;
+      }
+      expansionsNumber++;
+
+      auto relax = [&](std::uint64_t nextKey, std::uint32_t edgeCost)
+        {
+          auto [it, isInserted] = costs.emplace(nextKey, cost + edgeCost);
+          if (isInserted || cost + edgeCost < it->second)
+          {
+            it->second = cost + edgeCost;
+            parents[nextKey] = key;
+            open.push(std::make_pair(it->second + GetEstimate(GetKeyCell(nextKey), goal), nextKey));
+          }
+        };
+
+      if (key == startKey)
+      {
+        for (const auto& [nodeKey, distance] : startEdges)
+        {
+          relax(nodeKey, distance);
+        }
+      }
+
+      std::pair<int, int> chunkPosition = GetChunkPosition(cell);
+      const ChunkGraph* graph = getGraph(chunkPosition);
+      auto nodeIt = graph ? graph->indices.find(key) : std::unordered_map<std::uint64_t, std::uint32_t>::const_iterator();
+      if (graph && nodeIt != graph->indices.end())
+      {
+        const ChunkGraph::Node& node = graph->nodes[nodeIt->second];
+        for (const auto& [index, distance] : node.edges)
+        {
+          relax(GetCellKey(graph->nodes[index].cell), distance);
+        }
+        for (const glm::ivec3& partner : node.partners)
+        {
+          relax(GetCellKey(partner), 1);
+        }
+      }
+
+      if (chunkPosition == goalChunk)
+      {
+        auto goalIt = goalEdges.find(key);
+        if (goalIt != goalEdges.end())
+        {
+          relax(goalKey, goalIt->second);
+        }
+      }
+    }
+
+    if (!isFound)
+    {
+      return {};
+    }
+
+    std::vector<glm::ivec3> waypoints;
+    for (std::uint64_t key = goalKey; ; key = parents[key])
+    {
+      waypoints.push_back(GetKeyCell(key));
+      if (key == startKey)
+      {
+        break;
+      }
+    }
+    std::reverse(waypoints.begin(), waypoints.end());
+
+    // Portal hops are single steps, moves inside a chunk are walked again cell by cell
+    std::vector<glm::ivec3> path = { start };
+    for (size_t i = 1; i < waypoints.size(); i++)
+    {
+      if (GetChunkPosition(waypoints[i - 1]) != GetChunkPosition(waypoints[i]))
+      {
+        path.push_back(waypoints[i]);
+        continue;
+      }
+
+      std::vector<glm::ivec3> segment = FindLocalPath(view, waypoints[i - 1], waypoints[i]);
+      if (segment.empty())
+      {
+        return {};
+      }
+      path.insert(path.end(), segment.begin() + 1, segment.end());
+    }
+
+    return path;
+  }
+
+  bool PathGraph::FindStandingCell(Map& map, glm::ivec3 cell, glm::ivec3& standingCell)
+  {
+    GridView view(map);
+    for (int z = std::min(cell.z, (int)Chunk::Height - 1); z > 0; z--)
+    {
+      if (view.IsWalkable(glm::ivec3(cell.x, cell.y, z)))
+      {
+        standingCell = glm::ivec3(cell.x, cell.y, z);
+        return true;
+      }
+    }
+
+    return false;
+  }
+
+
+  void PathGraph::InvalidateCell(glm::ivec3 cell)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    generation_++;
+
+    // Distances inside the chunk may change anywhere, portals only when the cell is on a border
+    std::pair<int, int> position = GetChunkPosition(cell);
+    glm::ivec3 localCell = glm::ivec3(cell.x - position.first * (int)Chunk::Length, cell.y - position.second * (int)Chunk::Width, cell.z);
+    chunkGraphs_.erase(position);
+
+    if (localCell.x == (int)Chunk::Length - 1)
+    {
+      borders_.erase(std::make_pair(position, 0));
+      chunkGraphs_.erase(std::make_pair(position.first + 1, position.second));
+    }
+    if (localCell.x == 0)
+    {
+      borders_.erase(std::make_pair(std::make_pair(position.first - 1, position.second), 0));
+      chunkGraphs_.erase(std::make_pair(position.first - 1, position.second));
+    }
+    if (localCell.y == (int)Chunk::Width - 1)
+    {
+      borders_.erase(std::make_pair(position, 1));
+      chunkGraphs_.erase(std::make_pair(position.first, position.second + 1));
+    }
+    if (localCell.y == 0)
+    {
+      borders_.erase(std::make_pair(std::make_pair(position.first, position.second - 1), 1));
+      chunkGraphs_.erase(std::make_pair(position.first, position.second - 1));
+    }
+  }
+
+  void PathGraph::ReleaseChunk(std::pair<int, int> position)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    // Searches still building from the chunk do not cache what they built
+    generation_++;
+    chunkGraphs_.erase(position);
+    borders_.erase(std::make_pair(position, 0));
+    borders_.erase(std::make_pair(position, 1));
+    borders_.erase(std::make_pair(std::make_pair(position.first - 1, position.second), 0));
+    borders_.erase(std::make_pair(std::make_pair(position.first, position.second - 1), 1));
+  }
+
+  void PathGraph::Clear()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    generation_++;
+    borders_.clear();
+    chunkGraphs_.clear();
+  }
+
+
+  std::shared_ptr<const std::vector<PathGraph::Portal>> PathGraph::GetBorder(GridView& view, BorderKey key)
+  {
+    std::uint64_t generation;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      auto it = borders_.find(key);
+      if (it != borders_.end())
+      {
+        return it->second;
+      }
+      generation = generation_;
+    }
+
+    auto [position, direction] = key;
+    glm::ivec3 across = direction == 0 ? glm::ivec3(1, 0, 0) : glm::ivec3(0, 1, 0);
+    std::pair<int, int> neighbour = std::make_pair(position.first + across.x, position.second + across.y);
+    bool isComplete = view.IsResident(position) && view.IsResident(neighbour);
+
+    std::shared_ptr<std::vector<Portal>> portals = std::make_shared<std::vector<Portal>>();
+    if (isComplete)
+    {
+      glm::ivec3 origin = glm::ivec3(position.first * (int)Chunk::Length, position.second * (int)Chunk::Width, 0);
+      glm::ivec3 along = direction == 0 ? glm::ivec3(0, 1, 0) : glm::ivec3(1, 0, 0);
+      glm::ivec3 edge = direction == 0 ? glm::ivec3((int)Chunk::Length - 1, 0, 0) : glm::ivec3(0, (int)Chunk::Width - 1, 0);
+      int borderLength = direction == 0 ? (int)Chunk::Width : (int)Chunk::Length;
+
+      // Runs of steps along the border at the same height, one portal in the middle of each
+      std::vector<bool> isWalkable(borderLength);
+      for (int z = 1; z < (int)Chunk::Height; z++)
+      {
+        bool isAnyWalkable = false;
+        for (int t = 0; t < borderLength; t++)
+        {
+          isWalkable[t] = view.IsWalkable(origin + edge + along * t + Up * z);
+          isAnyWalkable = isAnyWalkable || isWalkable[t];
+        }
+        if (!isAnyWalkable)
+        {
+          continue;
+        }
+
+        for (int dz = -1; dz <= 1; dz++)
+        {
+          int runStart = -1;
+          for (int t = 0; t <= borderLength; t++)
+          {
+            glm::ivec3 inside = origin + edge + along * t + Up * z;
+            bool isStep = t < borderLength && isWalkable[t] && view.CanStep(inside, inside + across + Up * dz);
+            if (isStep && runStart < 0)
+            {
+              runStart = t;
+            }
+            else if (!isStep && runStart >= 0)
+            {
+              glm::ivec3 portalCell = origin + edge + along * ((runStart + t - 1) / 2) + Up * z;
+              portals->push_back(Portal{ portalCell, portalCell + across + Up * dz });
+              runStart = -1;
+            }
+          }
+        }
+      }
+    }
+
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (isComplete && generation == generation_)
+    {
+      borders_.emplace(key, portals);
+    }
+
+    return portals;
+  }
+
+  std::shared_ptr<const PathGraph::ChunkGraph> PathGraph::GetChunkGraph(GridView& view, std::pair<int, int> position)
+  {
+    std::uint64_t generation;
+    {
+      std::lock_guard<std::mutex> locker(mutex_);
+
+      auto it = chunkGraphs_.find(position);
+      if (it != chunkGraphs_.end())
+      {
+        return it->second;
+      }
+      generation = generation_;
+    }
+
+    if (!view.IsResident(position))
+    {
+      return nullptr;
+    }
+
+    std::shared_ptr<ChunkGraph> graph = std::make_shared<ChunkGraph>();
+    auto addNode = [&graph](glm::ivec3 cell, glm::ivec3 partner)
+      {
+        auto [it, isInserted] = graph->indices.emplace(GetCellKey(cell), (std::uint32_t)graph->nodes.size());
+        if (isInserted)
+        {
+          graph->nodes.push_back(ChunkGraph::Node{ cell });
+        }
+        graph->nodes[it->second].partners.push_back(partner);
+      };
+
+    // Borders towards +x and +y belong to this chunk, the other two to the neighbours
+    std::shared_ptr<const std::vector<Portal>> ownBorders[2] = {
+      GetBorder(view, std::make_pair(position, 0)),
+      GetBorder(view, std::make_pair(position, 1))
+    };
+    std::shared_ptr<const std::vector<Portal>> neighbourBorders[2] = {
+      GetBorder(view, std::make_pair(std::make_pair(position.first - 1, position.second), 0)),
+      GetBorder(view, std::make_pair(std::make_pair(position.first, position.second - 1), 1))
+    };
+    for (int i = 0; i < 2; i++)
+    {
+      for (const Portal& portal : *ownBorders[i])
+      {
+        addNode(portal.inside, portal.outside);
+      }
+      for (const Portal& portal : *neighbourBorders[i])
+      {
+        addNode(portal.outside, portal.inside);
+      }
+    }
+
+    std::unordered_map<std::uint64_t, std::uint64_t> parents;
+    for (std::uint32_t i = 0; i < graph->nodes.size(); i++)
+    {
+      parents.clear();
+      WalkChunk(view, graph->nodes[i].cell, parents, [&](glm::ivec3 cell, std::uint32_t distance)
+        {
+          auto it = graph->indices.find(GetCellKey(cell));
+          if (it != graph->indices.end() && it->second != i)
+          {
+            graph->nodes[i].edges.emplace_back(it->second, distance);
+          }
+          return false;
+        });
+    }
+
+    bool isComplete = view.IsResident(std::make_pair(position.first + 1, position.second)) && view.IsResident(std::make_pair(position.first - 1, position.second)) &&
+      view.IsResident(std::make_pair(position.first, position.second + 1)) && view.IsResident(std::make_pair(position.first, position.second - 1));
+
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (isComplete && generation == generation_)
+    {
+      chunkGraphs_.emplace(position, graph);
+    }
+
+    return graph;
+  }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "map.hpp"
+
+
+namespace blocks
+{
+  // Walking paths over the block grid found with HPA*: chunks are clusters, walkable cell pairs across chunk borders
+  // are grouped in runs with one portal each, and every chunk caches walking distances between its portals.
+  // The search runs A* over portals and refines each step with a search inside one chunk.
+  // Graph parts are built lazily from resident chunks, non-resident chunks are treated as solid.
+  class PathGraph
+  {
+  public:
+    // Agent stands on a solid block and needs this many free cells above it
+    static const int AgentHeight = 2;
+    static const size_t DefaultSearchLimit = 1 << 16;
+
+    PathGraph();
+    PathGraph(const PathGraph&) = delete;
+    PathGraph(PathGraph&& other) = delete;
+    PathGraph& operator=(const PathGraph&) = delete;
+    PathGraph& operator=(PathGraph&& other) = delete;
+
+    // Thread safe, the graph is shared by all searches. Returns an empty path when the goal is not reachable
+    // within searchLimit portal expansions, otherwise every cell from start to goal.
+    std::vector<glm::ivec3> FindPath(Map& map, glm::ivec3 start, glm::ivec3 goal, size_t searchLimit = DefaultSearchLimit);
+    // First cell at or below the given one an agent can stand in
+    bool FindStandingCell(Map& map, glm::ivec3 cell, glm::ivec3& standingCell);
+
+    // Drops portals and distances an edited block may have changed
+    void InvalidateCell(glm::ivec3 cell);
+    // Drops the graph of a chunk that left memory along with its borders, they are rebuilt once it is back
+    void ReleaseChunk(std::pair<int, int> position);
+    void Clear();
+
+  private:
+    struct Portal
+    {
+      // Cell of the lower chunk and the cell it steps to in the chunk across the border
+      glm::ivec3 inside;
+      glm::ivec3 outside;
+    };
+
+    struct ChunkGraph
+    {
+      struct Node
+      {
+        glm::ivec3 cell;
+        // Cells in neighbour chunks reachable in one step
+        std::vector<glm::ivec3> partners;
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> edges;
+      };
+
+      std::vector<Node> nodes;
+      std::unordered_map<std::uint64_t, std::uint32_t> indices;
+    };
+
+    class GridView;
+
+    // Border between a chunk and its +x (direction 0) or +y (direction 1) neighbour
+    typedef std::pair<std::pair<int, int>, int> BorderKey;
+
+    // Breadth first walk that stays inside one chunk, stops once visit returns true
+    template<typename Visitor>
+    static void WalkChunk(GridView& view, glm::ivec3 start, std::unordered_map<std::uint64_t, std::uint64_t>& parents, Visitor visit);
+    // Cells from start to goal inside the chunk of both, empty when there is no such path
+    static std::vector<glm::ivec3> FindLocalPath(GridView& view, glm::ivec3 start, glm::ivec3 goal);
+
+    std::shared_ptr<const std::vector<Portal>> GetBorder(GridView& view, BorderKey key);
+    // nullptr when the chunk is not resident
+    std::shared_ptr<const ChunkGraph> GetChunkGraph(GridView& view, std::pair<int, int> position);
+
+    std::map<BorderKey, std::shared_ptr<const std::vector<Portal>>> borders_;
+    std::map<std::pair<int, int>, std::shared_ptr<const ChunkGraph>> chunkGraphs_;
+    // Parts built from blocks older than the last invalidation are not cached
+    std::uint64_t generation_ = 0;
+    std::mutex mutex_;
+  };
+}
@@ -0,0 +1,376 @@
+#include "region_file.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <format>
+
+#include "io/file_api.hpp"
+#include "hash/hash_api.hpp"
+#include "math_utils.hpp"
+
+
+namespace blocks
+{
+  RegionFile::RegionFile(std::string path) : path_(path)
+  {
+    memset(&header_, 0, sizeof(RegionHeader));
+
+    if (!blocks::isPathExist(path))
+    {
+      std::ofstream createStream(path, std::ios::out | std::ios::binary);
+    }
+
+    file_.open(path, std::ios::in | std::ios::out | std::ios::binary);
+    if (!file_)
+    {
+      return;
+    }
+
+    file_.seekg(0, std::ios::end);
+    std::uint64_t fileSize = (std::uint64_t)file_.tellg();
+
+    if (fileSize < HeaderSlotsNumber * HeaderSectorsNumber * SectorSize)
+    {
+      // New or truncated file, start with an empty table in the first slot
+      header_.magic = RegionHeader::Magic;
+      header_.version = RegionHeader::Version;
+      header_.sequence = 1;
+      header_.checksum = ComputeChecksum(header_);
+
+      std::vector<char> emptyHeaders(HeaderSlotsNumber * HeaderSectorsNumber * SectorSize, 0);
+      memcpy(&emptyHeaders[0], &header_, sizeof(RegionHeader));
+
+      file_.seekp(0);
+      file_.write(&emptyHeaders[0], emptyHeaders.size());
+      file_.flush();
+
+      fileSize = emptyHeaders.size();
+      committedSlot_ = 0;
+    }
+    else
+    {
+      // Newest valid slot wins, a torn table write leaves the other one intact
+      std::unique_ptr<RegionHeader> slotHeader = std::make_unique<RegionHeader>();
+      bool isFound = false;
+      for (int slot = 0; slot < (int)HeaderSlotsNumber; slot++)
+      {
+        file_.seekg((std::uint64_t)slot * HeaderSectorsNumber * SectorSize);
+        file_.read((char*)slotHeader.get(), sizeof(RegionHeader));
+        if (!file_)
+        {
+          file_.clear();
+          continue;
+        }
+
+        if (IsValid(*slotHeader) && (!isFound || slotHeader->sequence > header_.sequence))
+        {
+          header_ = *slotHeader;
+          committedSlot_ = slot;
+          isFound = true;
+        }
+      }
+
+      if (!isFound)
+      {
+        file_.close();
+        return;
+      }
+    }
+
+    usedSectors_.assign(fileSize / SectorSize, false);
+    for (std::uint32_t i = 0; i < HeaderSlotsNumber * HeaderSectorsNumber; i++)
+    {
+      usedSectors_[i] = true;
+    }
+
+    for (ChunkLocation& location : header_.locations)
+    {
+      if (location.sectorsNumber == 0)
+      {
+        continue;
+      }
+
+      // A location past the end of the file or larger than its sectors is dropped, the chunk reads as missing
+      if ((std::uint64_t)location.sectorOffset + location.sectorsNumber > usedSectors_.size() ||
+        location.dataSize > (std::uint64_t)location.sectorsNumber * SectorSize)
+      {
+        memset(&location, 0, sizeof(ChunkLocation));
+        continue;
+      }
+
+      for (std::uint32_t i = 0; i < location.sectorsNumber; i++)
+      {
+        usedSectors_[location.sectorOffset + i] = true;
+      }
+    }
+    committedHeader_ = header_;
+  }
+
+  RegionFile::~RegionFile()
+  {
+    Commit();
+  }
+
+
+  bool RegionFile::IsOpen() const
+  {
+    return file_.is_open();
+  }
+
+
+  bool RegionFile::ContainsChunk(std::pair<int, int> localPosition) const
+  {
+    return header_.locations[GetIndex(localPosition)].sectorsNumber != 0;
+  }
+
+  std::vector<std::pair<int, int>> RegionFile::GetChunkPositions() const
+  {
+    std::vector<std::pair<int, int>> positions;
+
+    for (int index = 0; index < ChunksNumber; index++)
+    {
+      if (header_.locations[index].sectorsNumber != 0)
+      {
+        positions.push_back(std::make_pair(index % RegionSize, index / RegionSize));
+      }
+    }
+
+    return positions;
+  }
+
+  std::span<const unsigned char> RegionFile::ReadChunk(std::pair<int, int> localPosition)
+  {
+    const ChunkLocation& location = header_.locations[GetIndex(localPosition)];
+    if (location.sectorsNumber == 0 || location.dataSize > (std::uint64_t)location.sectorsNumber * SectorSize)
+    {
+      return std::span<const unsigned char>();
+    }
+
+    if (!mapping_)
+    {
+      mapping_ = std::make_unique<MappedFile>(path_);
+    }
+
+    std::uint64_t offset = (std::uint64_t)location.sectorOffset * SectorSize;
+    if (offset + location.dataSize > mapping_->GetSize())
+    {
+      return std::span<const unsigned char>();
+    }
+
+    return mapping_->GetView().subspan(offset, location.dataSize);
+  }
+
+  void RegionFile::WriteChunk(std::pair<int, int> localPosition, const std::vector<unsigned char>& data)
+  {
+    int index = GetIndex(localPosition);
+    ChunkLocation& location = header_.locations[index];
+
+    std::uint32_t sectorsNumber = (std::uint32_t)((data.size() + SectorSize - 1) / SectorSize);
+
+    // File may grow or move sectors, the next read maps it again
+    mapping_.reset();
+
+    // Copy on write, the new payload always goes to sectors the committed table does not reference
+    ReleaseSectors(index);
+    location.sectorOffset = sectorsNumber != 0 ? AllocateSectors(sectorsNumber) : 0;
+    location.sectorsNumber = sectorsNumber;
+    location.dataSize = (std::uint32_t)data.size();
+    hasChanges_ = true;
+
+    if (sectorsNumber == 0)
+    {
+      return;
+    }
+
+    // Payload is padded to whole sectors so the file always ends on a sector boundary
+    std::vector<char> sectors(sectorsNumber * SectorSize, 0);
+    memcpy(&sectors[0], &data[0], data.size());
+
+    file_.seekp((std::uint64_t)location.sectorOffset * SectorSize);
+    file_.write(&sectors[0], sectors.size());
+    file_.flush();
+  }
+
+  bool RegionFile::Commit()
+  {
+    if (!file_.is_open() || !hasChanges_)
+    {
+      return true;
+    }
+
+    // Payloads have to be on disk before the table that points to them
+    file_.flush();
+    if (!file_ || !blocks::syncFile(path_))
+    {
+      file_.clear();
+      return false;
+    }
+
+    header_.sequence = committedHeader_.sequence + 1;
+    header_.checksum = ComputeChecksum(header_);
+
+    std::vector<char> headerSectors(HeaderSectorsNumber * SectorSize, 0);
+    memcpy(&headerSectors[0], &header_, sizeof(RegionHeader));
+
+    int slot = (committedSlot_ + 1) % HeaderSlotsNumber;
+    file_.seekp((std::uint64_t)slot * HeaderSectorsNumber * SectorSize);
+    file_.write(&headerSectors[0], headerSectors.size());
+    file_.flush();
+    if (!file_ || !blocks::syncFile(path_))
+    {
+      file_.clear();
+      return false;
+    }
+
+    committedHeader_ = header_;
+    committedSlot_ = slot;
+    hasChanges_ = false;
+
+    // Sectors of replaced chunks are free only once no committed table references them
+    for (const auto& [sectorOffset, sectorsNumber] : pendingFreeSectors_)
+    {
+      FreeSectors(sectorOffset, sectorsNumber);
+    }
+    pendingFreeSectors_.clear();
+
+    return true;
+  }
+
+
+  std::pair<int, int> RegionFile::GetRegionPosition(std::pair<int, int> chunkPosition)
+  {
+    return std::make_pair(floorDivide(chunkPosition.first, RegionSize), floorDivide(chunkPosition.second, RegionSize));
+  }
+
+  std::pair<int, int> RegionFile::GetLocalPosition(std::pair<int, int> chunkPosition)
+  {
+    std::pair<int, int> regionPosition = GetRegionPosition(chunkPosition);
+
+    return std::make_pair(chunkPosition.first - regionPosition.first * RegionSize, chunkPosition.second - regionPosition.second * RegionSize);
+  }
+
+  std::pair<int, int> RegionFile::GetChunkPosition(std::pair<int, int> regionPosition, std::pair<int, int> localPosition)
+  {
+    return std::make_pair(regionPosition.first * RegionSize + localPosition.first, regionPosition.second * RegionSize + localPosition.second);
+  }
+
+  std::string RegionFile::GetFileName(std::pair<int, int> regionPosition)
+  {
+    return std::format("r.{0}.{1}.region", regionPosition.first, regionPosition.second);
+  }
+
+  bool RegionFile::ParseFileName(const std::string& fileName, std::pair<int, int>& regionPosition)
+  {
+    int x = 0;
+    int y = 0;
+    char extension[8] = {};
+    if (sscanf(fileName.c_str(), "r.%d.%d.%7s", &x, &y, extension) != 3 || strcmp(extension, "region") != 0)
+    {
+      return false;
+    }
+
+    regionPosition = std::make_pair(x, y);
+    return true;
+  }
+
+
+  int RegionFile::GetIndex(std::pair<int, int> localPosition)
+  {
+    return localPosition.first + localPosition.second * RegionSize;
+  }
+
+  std::uint64_t RegionFile::ComputeChecksum(const RegionHeader& header)
+  {
+    std::uint64_t checksum = blocks::computeHash(&header.sequence, sizeof(header.sequence));
+    return blocks::computeHash(header.locations, sizeof(header.locations), checksum);
+  }
+
+  bool RegionFile::IsValid(const RegionHeader& header)
+  {
+    if (header.magic != RegionHeader::Magic || header.version != RegionHeader::Version || header.checksum != ComputeChecksum(header))
+    {
+      return false;
+    }
+
+    for (const ChunkLocation& location : header.locations)
+    {
+      if (location.sectorsNumber != 0 && location.sectorOffset < HeaderSlotsNumber * HeaderSectorsNumber)
+      {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
+  std::uint32_t RegionFile::AllocateSectors(std::uint32_t sectorsNumber)
+  {
+    // First fit over freed sectors, otherwise grow the file
+    std::uint32_t runStart = 0;
+    std::uint32_t runLength = 0;
+    for (std::uint32_t i = HeaderSlotsNumber * HeaderSectorsNumber; i < usedSectors_.size(); i++)
+    {
+      if (usedSectors_[i])
+      {
+        runLength = 0;
+        continue;
+      }
+
+      if (runLength == 0)
+      {
+        runStart = i;
+      }
+      runLength++;
+
+      if (runLength == sectorsNumber)
+      {
+        break;
+      }
+    }
+
+    if (runLength < sectorsNumber)
+    {
+      // Trailing free run can be extended in place
+      if (runLength == 0 || runStart + runLength != usedSectors_.size())
+      {
+        runStart = (std::uint32_t)usedSectors_.size();
+      }
+      usedSectors_.resize(runStart + sectorsNumber, false);
+    }
+
+    for (std::uint32_t i = 0; i < sectorsNumber; i++)
+    {
+      usedSectors_[runStart + i] = true;
+    }
+
+    return runStart;
+  }
+
+  void RegionFile::FreeSectors(std::uint32_t sectorOffset, std::uint32_t sectorsNumber)
+  {
+    for (std::uint32_t i = 0; i < sectorsNumber; i++)
+    {
+      usedSectors_[sectorOffset + i] = false;
+    }
+  }
+
+  void RegionFile::ReleaseSectors(int index)
+  {
+    const ChunkLocation& location = header_.locations[index];
+    if (location.sectorsNumber == 0)
+    {
+      return;
+    }
+
+    const ChunkLocation& committedLocation = committedHeader_.locations[index];
+    if (location.sectorOffset == committedLocation.sectorOffset && location.sectorsNumber == committedLocation.sectorsNumber)
+    {
+      pendingFreeSectors_.emplace_back(location.sectorOffset, location.sectorsNumber);
+    }
+    else
+    {
+      // Written after the last commit, nothing on disk points here
+      FreeSectors(location.sectorOffset, location.sectorsNumber);
+    }
+  }
+}
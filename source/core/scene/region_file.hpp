@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "io/mapped_file.hpp"
+
+
+namespace blocks
+{
+  // Container for RegionSize x RegionSize chunks: two header table slots of sector locations followed by
+  // sector aligned chunk payloads. Writes never touch committed sectors, Commit syncs the payloads and
+  // then the table into the older slot, so a crash leaves the last committed table and its chunks intact.
+  class RegionFile
+  {
+  public:
+    static const int RegionSize = 32;
+    static const int ChunksNumber = RegionSize * RegionSize;
+    static const size_t SectorSize = 4096;
+
+    RegionFile(std::string path);
+    RegionFile(const RegionFile&) = delete;
+    RegionFile(RegionFile&& other) = delete;
+    RegionFile& operator=(const RegionFile&) = delete;
+    RegionFile& operator=(RegionFile&& other) = delete;
+    ~RegionFile();
+
+    bool IsOpen() const;
+
+    bool ContainsChunk(std::pair<int, int> localPosition) const;
+    std::vector<std::pair<int, int>> GetChunkPositions() const;
+    // Returned view points into the mapped file and is valid until the next write
+    std::span<const unsigned char> ReadChunk(std::pair<int, int> localPosition);
+    void WriteChunk(std::pair<int, int> localPosition, const std::vector<unsigned char>& data);
+    // Makes all writes since the previous commit durable with two file syncs
+    bool Commit();
+
+    static std::pair<int, int> GetRegionPosition(std::pair<int, int> chunkPosition);
+    static std::pair<int, int> GetLocalPosition(std::pair<int, int> chunkPosition);
+    static std::pair<int, int> GetChunkPosition(std::pair<int, int> regionPosition, std::pair<int, int> localPosition);
+    static std::string GetFileName(std::pair<int, int> regionPosition);
+    static bool ParseFileName(const std::string& fileName, std::pair<int, int>& regionPosition);
+
+  private:
+    struct ChunkLocation
+    {
+      std::uint32_t sectorOffset;
+      std::uint32_t sectorsNumber;
+      std::uint32_t dataSize;
+      std::uint32_t reserved;
+    };
+
+    struct RegionHeader
+    {
+      static const std::uint32_t Magic = 0x47455242; // "BREG"
+      static const std::uint32_t Version = 2;
+
+      std::uint32_t magic;
+      std::uint32_t version;
+      std::uint64_t sequence;
+      std::uint64_t checksum;
+      std::uint64_t reserved;
+      ChunkLocation locations[ChunksNumber];
+    };
+
+    static const std::uint32_t HeaderSectorsNumber = (sizeof(RegionHeader) + SectorSize - 1) / SectorSize;
+    static const std::uint32_t HeaderSlotsNumber = 2;
+
+    static int GetIndex(std::pair<int, int> localPosition);
+    static std::uint64_t ComputeChecksum(const RegionHeader& header);
+    static bool IsValid(const RegionHeader& header);
+
+    std::uint32_t AllocateSectors(std::uint32_t sectorsNumber);
+    void FreeSectors(std::uint32_t sectorOffset, std::uint32_t sectorsNumber);
+    void ReleaseSectors(int index);
+
+    std::string path_;
+    std::fstream file_;
+    std::unique_ptr<MappedFile> mapping_;
+    RegionHeader header_;
+    RegionHeader committedHeader_;
+    int committedSlot_ = 0;
+    bool hasChanges_ = false;
+    std::vector<bool> usedSectors_;
+    std::vector<std::pair<std::uint32_t, std::uint32_t>> pendingFreeSectors_;
+  };
+}
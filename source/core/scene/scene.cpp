@@ -31,6 +31,27 @@ namespace blocks
   }
 
 
+  std::shared_ptr<EntityWorld> Scene::GetEntities()
+  {
+    return entities_;
+  }
+
+  std::shared_ptr<FluidWorld> Scene::GetFluids()
+  {
+    return fluids_;
+  }
+
+  std::shared_ptr<PathGraph> Scene::GetPaths()
+  {
+    return paths_;
+  }
+
+  std::shared_ptr<ParticleWorld> Scene::GetParticles()
+  {
+    return particles_;
+  }
+
+
   std::pair<std::vector<std::shared_ptr<ImguiWindow>>::iterator, std::vector<std::shared_ptr<ImguiWindow>>::iterator> Scene::GetImguiWindowsIterator()
   {
     return std::make_pair(imguiWindows_.begin(), imguiWindows_.end());
@@ -5,6 +5,10 @@
 #include <utility>
 
 #include "map.hpp"
+#include "entity_world.hpp"
+#include "fluid_world.hpp"
+#include "path_graph.hpp"
+#include "particle_world.hpp"
 
 #include "ui/imgui_window.hpp"
 
@@ -22,10 +26,19 @@ namespace blocks
     void SetMap(std::shared_ptr<Map> map);
     std::shared_ptr<Map> GetMap();
 
+    std::shared_ptr<EntityWorld> GetEntities();
+    std::shared_ptr<FluidWorld> GetFluids();
+    std::shared_ptr<PathGraph> GetPaths();
+    std::shared_ptr<ParticleWorld> GetParticles();
+
     std::pair<std::vector<std::shared_ptr<ImguiWindow>>::iterator, std::vector<std::shared_ptr<ImguiWindow>>::iterator> GetImguiWindowsIterator();
 
   private:
     std::shared_ptr<Map> map_ = nullptr;
+    std::shared_ptr<EntityWorld> entities_ = std::make_shared<EntityWorld>();
+    std::shared_ptr<FluidWorld> fluids_ = std::make_shared<FluidWorld>();
+    std::shared_ptr<PathGraph> paths_ = std::make_shared<PathGraph>();
+    std::shared_ptr<ParticleWorld> particles_ = std::make_shared<ParticleWorld>();
     std::vector<std::shared_ptr<ImguiWindow>> imguiWindows_;
   };
 }
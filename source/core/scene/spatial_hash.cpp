@@ -0,0 +1,42 @@
+#include "spatial_hash.hpp"
+
+#include <bit>
+
+
+namespace blocks
+{
+  SpatialHash::SpatialHash(float cellSize) : inverseCellSize_(1.0f / cellSize)
+  {
+
+  }
+
+
+  void SpatialHash::Build(const float* x, const float* y, const float* z, size_t itemsNumber)
+  {
+    // Twice as many buckets as items keeps collisions rare
+    size_t bucketsNumber = std::bit_ceil(std::max<size_t>(itemsNumber * 2, 64));
+    bucketsMask_ = (std::uint32_t)(bucketsNumber - 1);
+    bucketStarts_.assign(bucketsNumber + 1, 0);
+    items_.resize(itemsNumber);
+    itemBuckets_.resize(itemsNumber);
+
+    for (size_t i = 0; i < itemsNumber; i++)
+    {
+      std::uint32_t bucket = GetBucket(GetCell(glm::vec3(x[i], y[i], z[i])));
+      itemBuckets_[i] = bucket;
+      bucketStarts_[bucket]++;
+    }
+
+    // Inclusive prefix sum gives bucket ends, filling from the back moves them to bucket starts
+    for (size_t bucket = 1; bucket < bucketsNumber; bucket++)
+    {
+      bucketStarts_[bucket] += bucketStarts_[bucket - 1];
+    }
+    bucketStarts_[bucketsNumber] = (std::uint32_t)itemsNumber;
+
+    for (size_t i = itemsNumber; i-- > 0;)
+    {
+      items_[--bucketStarts_[itemBuckets_[i]]] = (std::uint32_t)i;
+    }
+  }
+}
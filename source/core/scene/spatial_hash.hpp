@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "geometry/aabb.hpp"
+
+
+namespace blocks
+{
+  // Uniform grid broadphase, cells are hashed into a fixed bucket table rebuilt from scratch every tick.
+  // Items are sorted by bucket with a counting sort, so building is linear and allocation free once warmed up.
+  class SpatialHash
+  {
+  public:
+    SpatialHash(float cellSize);
+    SpatialHash(const SpatialHash&) = delete;
+    SpatialHash(SpatialHash&& other) = delete;
+    SpatialHash& operator=(const SpatialHash&) = delete;
+    SpatialHash& operator=(SpatialHash&& other) = delete;
+
+    void Build(const float* x, const float* y, const float* z, size_t itemsNumber);
+
+    // Visits every item whose point may lie in bounds, items from colliding cells are visited too
+    template <typename Visitor>
+    void Query(const AABB& bounds, Visitor visitor) const
+    {
+      if (items_.empty())
+      {
+        return;
+      }
+
+      glm::ivec3 low = GetCell(bounds.low);
+      glm::ivec3 high = GetCell(bounds.high);
+
+      // Several cells may share a bucket, each bucket is visited once
+      std::uint32_t buckets[QueryBucketsNumber];
+      size_t bucketsNumber = 0;
+      for (int x = low.x; x <= high.x; x++)
+      {
+        for (int y = low.y; y <= high.y; y++)
+        {
+          for (int z = low.z; z <= high.z; z++)
+          {
+            std::uint32_t bucket = GetBucket(glm::ivec3(x, y, z));
+            if (std::find(buckets, buckets + bucketsNumber, bucket) != buckets + bucketsNumber)
+            {
+              continue;
+            }
+
+            if (bucketsNumber == QueryBucketsNumber)
+            {
+              VisitBuckets(buckets, bucketsNumber, visitor);
+              bucketsNumber = 0;
+            }
+            buckets[bucketsNumber++] = bucket;
+          }
+        }
+      }
+      VisitBuckets(buckets, bucketsNumber, visitor);
+    }
+
+  private:
+    static const size_t QueryBucketsNumber = 64;
+
+    glm::ivec3 GetCell(glm::vec3 point) const
+    {
+      return glm::ivec3(glm::floor(point * inverseCellSize_));
+    }
+
+    std::uint32_t GetBucket(glm::ivec3 cell) const
+    {
+      std::uint32_t hash = ((std::uint32_t)cell.x * 73856093u) ^ ((std::uint32_t)cell.y * 19349663u) ^ ((std::uint32_t)cell.z * 83492791u);
+      return hash & bucketsMask_;
+    }
+
+    template <typename Visitor>
+    void VisitBuckets(const std::uint32_t* buckets, size_t bucketsNumber, Visitor& visitor) const
+    {
+      for (size_t i = 0; i < bucketsNumber; i++)
+      {
+        for (std::uint32_t item = bucketStarts_[buckets[i]]; item < bucketStarts_[buckets[i] + 1]; item++)
+        {
+          visitor(items_[item]);
+        }
+      }
+    }
+
+    float inverseCellSize_;
+    std::uint32_t bucketsMask_ = 0;
+    std::vector<std::uint32_t> bucketStarts_;
+    std::vector<std::uint32_t> items_;
+    std::vector<std::uint32_t> itemBuckets_;
+  };
+}
@@ -0,0 +1,150 @@
+#include "world_storage.hpp"
+
+#include "io/file_api.hpp"
+#include "chunk_codec.hpp"
+
+
+namespace blocks
+{
+  WorldStorage::WorldStorage(std::string directory, size_t maxOpenRegions) : directory_(directory), maxOpenRegions_(maxOpenRegions)
+  {
+    if (!blocks::isPathExist(directory_))
+    {
+      blocks::createDirectory(directory_);
+      return;
+    }
+
+    for (const std::string& fileName : blocks::getFilesInDirectory(directory_))
+    {
+      std::pair<int, int> regionPosition;
+      if (!RegionFile::ParseFileName(fileName, regionPosition))
+      {
+        continue;
+      }
+
+      RegionFile* regionFile = OpenRegion(regionPosition);
+      if (regionFile == nullptr)
+      {
+        continue;
+      }
+
+      for (const std::pair<int, int>& localPosition : regionFile->GetChunkPositions())
+      {
+        savedChunks_.insert(RegionFile::GetChunkPosition(regionPosition, localPosition));
+      }
+    }
+  }
+
+  WorldStorage::~WorldStorage()
+  {
+
+  }
+
+
+  const std::string& WorldStorage::GetDirectory() const
+  {
+    return directory_;
+  }
+
+  size_t WorldStorage::GetChunksNumber()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return savedChunks_.size();
+  }
+
+
+  bool WorldStorage::ContainsChunk(std::pair<int, int> position)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    return savedChunks_.find(position) != savedChunks_.end();
+  }
+
+  std::shared_ptr<Chunk> WorldStorage::ReadChunk(std::pair<int, int> position, std::vector<ScheduledTick>* ticks)
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    if (savedChunks_.find(position) == savedChunks_.end())
+    {
+      return nullptr;
+    }
+
+    RegionFile* regionFile = OpenRegion(RegionFile::GetRegionPosition(position));
+    if (regionFile == nullptr)
+    {
+      return nullptr;
+    }
+
+    std::span<const unsigned char> data = regionFile->ReadChunk(RegionFile::GetLocalPosition(position));
+
+    std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+    if (data.empty() || !ChunkCodec::Decode(data.data(), data.size(), *chunk, ticks))
+    {
+      return nullptr;
+    }
+
+    return chunk;
+  }
+
+  size_t WorldStorage::WriteChunk(std::pair<int, int> position, const Chunk& chunk, const std::vector<ScheduledTick>& ticks)
+  {
+    std::vector<unsigned char> data = ChunkCodec::Encode(chunk, ticks);
+
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    RegionFile* regionFile = OpenRegion(RegionFile::GetRegionPosition(position));
+    if (regionFile == nullptr)
+    {
+      return 0;
+    }
+
+    regionFile->WriteChunk(RegionFile::GetLocalPosition(position), data);
+    savedChunks_.insert(position);
+
+    return data.size();
+  }
+
+
+  bool WorldStorage::Commit()
+  {
+    std::lock_guard<std::mutex> locker(mutex_);
+
+    bool result = true;
+    for (auto& [regionPosition, regionFile] : regionHandles_)
+    {
+      result = regionFile->Commit() && result;
+    }
+
+    return result;
+  }
+
+
+  RegionFile* WorldStorage::OpenRegion(std::pair<int, int> regionPosition)
+  {
+    auto it = regionHandlesIndex_.find(regionPosition);
+    if (it != regionHandlesIndex_.end())
+    {
+      regionHandles_.splice(regionHandles_.begin(), regionHandles_, it->second);
+      return regionHandles_.front().second.get();
+    }
+
+    std::unique_ptr<RegionFile> regionFile = std::make_unique<RegionFile>(directory_ + "/" + RegionFile::GetFileName(regionPosition));
+    if (!regionFile->IsOpen())
+    {
+      return nullptr;
+    }
+
+    // Evicted regions commit their pending writes when closed
+    while (!regionHandles_.empty() && regionHandles_.size() >= maxOpenRegions_)
+    {
+      regionHandlesIndex_.erase(regionHandles_.back().first);
+      regionHandles_.pop_back();
+    }
+
+    regionHandles_.emplace_front(regionPosition, std::move(regionFile));
+    regionHandlesIndex_[regionPosition] = regionHandles_.begin();
+
+    return regionHandles_.front().second.get();
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "chunk.hpp"
+#include "chunk_codec.hpp"
+#include "region_file.hpp"
+
+
+namespace blocks
+{
+  // Saved world directory: index of stored chunks built from region headers at open time,
+  // chunk payloads are read on demand from mapped region files. Only the open region handles are
+  // bounded by an LRU, the page cache keeps recently read payloads and Map keeps decoded chunks.
+  class WorldStorage
+  {
+  public:
+    static const size_t DefaultMaxOpenRegions = 8;
+
+    WorldStorage(std::string directory, size_t maxOpenRegions = DefaultMaxOpenRegions);
+    WorldStorage(const WorldStorage&) = delete;
+    WorldStorage(WorldStorage&& other) = delete;
+    WorldStorage& operator=(const WorldStorage&) = delete;
+    WorldStorage& operator=(WorldStorage&& other) = delete;
+    ~WorldStorage();
+
+    const std::string& GetDirectory() const;
+    size_t GetChunksNumber();
+
+    bool ContainsChunk(std::pair<int, int> position);
+    std::shared_ptr<Chunk> ReadChunk(std::pair<int, int> position, std::vector<ScheduledTick>* ticks = nullptr);
+    size_t WriteChunk(std::pair<int, int> position, const Chunk& chunk, const std::vector<ScheduledTick>& ticks = {});
+    // Group commit, one data and one table sync per region written since the last commit
+    bool Commit();
+
+  private:
+    typedef std::list<std::pair<std::pair<int, int>, std::unique_ptr<RegionFile>>> RegionHandleList;
+
+    RegionFile* OpenRegion(std::pair<int, int> regionPosition);
+
+    std::string directory_;
+    size_t maxOpenRegions_;
+    std::set<std::pair<int, int>> savedChunks_;
+    // Most recently used region handles first
+    RegionHandleList regionHandles_;
+    std::map<std::pair<int, int>, RegionHandleList::iterator> regionHandlesIndex_;
+    std::mutex mutex_;
+  };
+}
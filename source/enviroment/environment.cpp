@@ -6,10 +6,12 @@ namespace blocks
   void Environment::Init()
   {
     platform_.Init();
+    resource_.SetIoService(&ioService_);
   }
 
   void Environment::Deinit()
   {
+    ioService_.Stop();
     platform_.Deinit();
   }
 
@@ -24,7 +26,13 @@ namespace blocks
     return resource_;
   }
 
+  AsyncIoService& Environment::GetIoService()
+  {
+    return ioService_;
+  }
+
 
   GlfwPlatform Environment::platform_ = GlfwPlatform();
   ResourceBase Environment::resource_ = ResourceBase();
+  AsyncIoService Environment::ioService_;
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "export.h"
+#include "io/async_io_service.hpp"
 #include "resource/resource_base.hpp"
 #include "platform/glfw_platform.hpp"
 
@@ -18,9 +19,11 @@ namespace blocks
 
     static GlfwPlatform& GetPlatform();
     static ResourceBase& GetResource();
+    static AsyncIoService& GetIoService();
 
   private:
     static GlfwPlatform platform_;
     static ResourceBase resource_;
+    static AsyncIoService ioService_;
   };
 }
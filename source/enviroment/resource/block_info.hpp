@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 
@@ -9,5 +10,14 @@ namespace blocks
   {
     std::string name;
     int textures[6];
+    bool isSolid = true;
+    bool isOpaque = true;
+    std::uint8_t lightEmission = 0;
+    // Zero for blocks that are not fluids
+    std::uint8_t fluidSpread = 0;
+    std::uint8_t fluidDelay = 0;
+    // Zero for blocks that never change on their own, otherwise ticks until the block turns into tickBlock
+    std::uint16_t tickDelay = 0;
+    std::uint16_t tickBlock = 0;
   };
 }
@@ -0,0 +1,40 @@
+#include "block_registry.hpp"
+
+#include <algorithm>
+
+
+namespace blocks
+{
+  BlockRegistry::BlockRegistry(const std::vector<BlockInfo>& blocks)
+  {
+    size_t blocksNumber = blocks.size() + 1;
+
+    faceTextures_.assign(blocksNumber * FacesNumber, 0);
+    flags_.assign(blocksNumber, 0);
+    lightEmission_.assign(blocksNumber, 0);
+    fluidSpread_.assign(blocksNumber, 0);
+    fluidDelay_.assign(blocksNumber, 0);
+    tickDelay_.assign(blocksNumber, 0);
+    tickBlock_.assign(blocksNumber, 0);
+
+    // Block set entries start from id 1, id 0 stays empty air
+    for (size_t i = 0; i < blocks.size(); i++)
+    {
+      const BlockInfo& info = blocks[i];
+      Block block = (Block)(i + 1);
+
+      for (size_t face = 0; face < FacesNumber; face++)
+      {
+        faceTextures_[block * FacesNumber + face] = (std::uint16_t)info.textures[face];
+      }
+
+      flags_[block] = (info.isSolid ? SolidFlag : 0) | (info.isOpaque ? OpaqueFlag : 0);
+      lightEmission_[block] = info.lightEmission;
+      fluidSpread_[block] = info.fluidSpread;
+      fluidDelay_[block] = info.fluidSpread != 0 ? std::max<std::uint8_t>(info.fluidDelay, 1) : 0;
+      // Targets outside the set would index past the tables, such blocks decay into air
+      tickDelay_[block] = info.tickDelay;
+      tickBlock_[block] = info.tickBlock < blocksNumber ? info.tickBlock : 0;
+    }
+  }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "block.hpp"
+#include "block_info.hpp"
+#include "memory/aligned_allocator.hpp"
+
+
+namespace blocks
+{
+  // Block properties compiled into flat arrays indexed directly by Block id, id 0 is air.
+  // Ids are not checked, callers must only pass ids of the block set the registry was built from.
+  // State bits of a block are ignored, lookups only use its type.
+  class BlockRegistry
+  {
+  public:
+    static const size_t FacesNumber = 6;
+
+    BlockRegistry(const std::vector<BlockInfo>& blocks);
+
+    size_t GetBlocksNumber() const
+    {
+      return flags_.size();
+    }
+
+    bool IsSolid(Block block) const
+    {
+      return (flags_[GetBlockType(block)] & SolidFlag) != 0;
+    }
+
+    bool IsOpaque(Block block) const
+    {
+      return (flags_[GetBlockType(block)] & OpaqueFlag) != 0;
+    }
+
+    bool IsLightEmitting(Block block) const
+    {
+      return lightEmission_[GetBlockType(block)] != 0;
+    }
+
+    std::uint8_t GetLightEmission(Block block) const
+    {
+      return lightEmission_[GetBlockType(block)];
+    }
+
+    bool IsFluid(Block block) const
+    {
+      return fluidSpread_[GetBlockType(block)] != 0;
+    }
+
+    // Number of cells a fluid flows sideways from its source
+    std::uint8_t GetFluidSpread(Block block) const
+    {
+      return fluidSpread_[GetBlockType(block)];
+    }
+
+    // Simulation ticks between two flow steps
+    std::uint8_t GetFluidDelay(Block block) const
+    {
+      return fluidDelay_[GetBlockType(block)];
+    }
+
+    bool IsTicking(Block block) const
+    {
+      return tickDelay_[GetBlockType(block)] != 0;
+    }
+
+    // Simulation ticks a placed block waits before it turns into its tick block
+    std::uint16_t GetTickDelay(Block block) const
+    {
+      return tickDelay_[GetBlockType(block)];
+    }
+
+    Block GetTickBlock(Block block) const
+    {
+      return tickBlock_[GetBlockType(block)];
+    }
+
+    std::uint16_t GetTexture(Block block, int face) const
+    {
+      return faceTextures_[GetBlockType(block) * FacesNumber + face];
+    }
+
+  private:
+    static const std::uint8_t SolidFlag = 1 << 0;
+    static const std::uint8_t OpaqueFlag = 1 << 1;
+
+    std::vector<std::uint16_t, AlignedAllocator<std::uint16_t>> faceTextures_;
+    std::vector<std::uint8_t, AlignedAllocator<std::uint8_t>> flags_;
+    std::vector<std::uint8_t, AlignedAllocator<std::uint8_t>> lightEmission_;
+    std::vector<std::uint8_t, AlignedAllocator<std::uint8_t>> fluidSpread_;
+    std::vector<std::uint8_t, AlignedAllocator<std::uint8_t>> fluidDelay_;
+    std::vector<std::uint16_t, AlignedAllocator<std::uint16_t>> tickDelay_;
+    std::vector<std::uint16_t, AlignedAllocator<std::uint16_t>> tickBlock_;
+  };
+}
@@ -3,27 +3,53 @@
 
 namespace blocks
 {
-  BlockSet::BlockSet(int resolution) : resolution_(resolution), blocks_()
+  BlockSet::BlockSet(std::string name, int resolution, std::uint64_t sourceHash) : name_(name), resolution_(resolution), sourceHash_(sourceHash), blocks_()
   {
   }
 
 
+  std::string BlockSet::GetName()
+  {
+    return name_;
+  }
+
   int BlockSet::GetResolution()
   {
     return resolution_;
   }
 
+  std::uint64_t BlockSet::GetSourceHash()
+  {
+    return sourceHash_;
+  }
+
 
   void BlockSet::AddBlockInfo(BlockInfo blockInfo)
   {
     blocks_.push_back(blockInfo);
   }
 
-  BlockInfo BlockSet::GetBlockInfo(int index)
+  const BlockInfo& BlockSet::GetBlockInfo(int index)
   {
     return blocks_.at(index);
   }
 
+  size_t BlockSet::GetBlocksNumber()
+  {
+    return blocks_.size();
+  }
+
+
+  void BlockSet::CompileRegistry()
+  {
+    registry_ = std::make_shared<BlockRegistry>(blocks_);
+  }
+
+  std::shared_ptr<const BlockRegistry> BlockSet::GetRegistry()
+  {
+    return registry_;
+  }
+
 
   void BlockSet::AddTexture(std::string path)
   {
@@ -1,8 +1,12 @@
 #pragma once
 
+#include <cstdint>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "block_info.hpp"
+#include "block_registry.hpp"
 
 
 namespace blocks
@@ -10,20 +14,29 @@ namespace blocks
   class BlockSet
   {
   public:
-    BlockSet(int resolution);
+    BlockSet(std::string name, int resolution, std::uint64_t sourceHash);
 
+    std::string GetName();
     int GetResolution();
+    std::uint64_t GetSourceHash();
 
     void AddBlockInfo(BlockInfo blockInfo);
-    BlockInfo GetBlockInfo(int index);
+    const BlockInfo& GetBlockInfo(int index);
+    size_t GetBlocksNumber();
+
+    void CompileRegistry();
+    std::shared_ptr<const BlockRegistry> GetRegistry();
 
     void AddTexture(std::string path);
     std::string GetTexture(int index);
     size_t GetTexturesNumber();
 
   private:
+    std::string name_;
     int resolution_;
+    std::uint64_t sourceHash_;
     std::vector<BlockInfo> blocks_;
+    std::shared_ptr<const BlockRegistry> registry_;
     std::vector<std::string> textures_;
   };
 }
@@ -1,10 +1,17 @@
 #include "resource_base.hpp"
 
+#include <climits>
+#include <filesystem>
+#include <future>
+
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb/stb_image.h"
 #include "nlohmann/json.hpp"
 
+#include "resourceConfig.h"
 #include "io/file_api.hpp"
+#include "io/mapped_file.hpp"
+#include "hash/hash_api.hpp"
 
 
 namespace blocks
@@ -12,6 +19,7 @@ namespace blocks
   ResourceBase::ResourceBase()
   {
     blockSetPaths_ = std::make_shared<std::vector<std::string>>();
+    fontNames_ = std::make_shared<std::vector<std::string>>();
   }
 
   ResourceBase::~ResourceBase()
@@ -20,15 +28,19 @@ namespace blocks
   }
 
 
-  void ResourceBase::SetUp(std::string path)
+  bool ResourceBase::SetUp(std::string path)
   {
     if (!blocks::isPathExist(path))
     {
-      return;
+      return false;
+    }
+
+    if (std::filesystem::path(path).extension() == ".pack")
+    {
+      return SetUpPack(path);
     }
 
-    size_t found = path.find_last_of("/\\");
-    rootDirectory_ = (path.substr(0, found));
+    rootDirectory_ = std::filesystem::path(path).parent_path().string();
 
     std::string resourceBaseStr = blocks::readTextFile(path);
 
@@ -38,6 +50,113 @@ namespace blocks
     {
       blockSetPaths_->push_back(value["Name"]);
     }
+
+    nlohmann::json fonts = resourceBaseJson["Fonts"];
+    for (auto& [key, value] : fonts.items())
+    {
+      std::string fontPath = value["Path"];
+      fontNames_->push_back(value["Name"]);
+      fontPaths_[value["Name"]] = (std::filesystem::path(rootDirectory_) / "Fonts" / fontPath).string();
+    }
+
+    return !blockSetPaths_->empty();
+  }
+
+  bool ResourceBase::SetUpPack(std::string path)
+  {
+    pack_ = std::make_unique<ResourcePack>(path);
+    if (!pack_->IsOpen())
+    {
+      pack_.reset();
+      return false;
+    }
+
+    // Only the index is touched, entries are read on demand straight from the mapping
+    for (size_t i = 0; i < pack_->GetEntriesNumber(); i++)
+    {
+      const ResourcePackEntry& entry = pack_->GetEntry(i);
+      if (entry.type == ResourcePackEntryType::BlockSet)
+      {
+        blockSetPaths_->push_back(entry.name);
+      }
+      else if (entry.type == ResourcePackEntryType::Font)
+      {
+        fontNames_->push_back(entry.name);
+      }
+    }
+
+    // Block sets are small, they are all loaded here so a broken pack is refused before anything uses it
+    bool isValid = !blockSetPaths_->empty();
+    for (size_t i = 0; i < blockSetPaths_->size() && isValid; i++)
+    {
+      const std::string& name = (*blockSetPaths_)[i];
+      std::shared_ptr<BlockSet> blockSet = LoadPackedBlockSet(name);
+      isValid = blockSet && LoadPackedTextureArray(name).data;
+      blockSets_[name] = blockSet;
+    }
+
+    if (!isValid)
+    {
+      pack_.reset();
+      blockSetPaths_->clear();
+      blockSets_.clear();
+      fontNames_->clear();
+    }
+
+    return isValid;
+  }
+
+  void ResourceBase::SavePack(std::string path)
+  {
+    ResourcePackWriter writer;
+
+    for (const std::string& name : *blockSetPaths_)
+    {
+      std::shared_ptr<BlockSet> blockSet = LoadBlockSet(name);
+
+      std::vector<unsigned char> data(sizeof(PackedBlockSetHeader) + blockSet->GetBlocksNumber() * sizeof(PackedBlock), 0);
+
+      PackedBlockSetHeader header;
+      header.resolution = blockSet->GetResolution();
+      header.blocksNumber = (std::uint32_t)blockSet->GetBlocksNumber();
+      header.texturesNumber = (std::uint32_t)blockSet->GetTexturesNumber();
+      header.reserved = 0;
+      header.sourceHash = blockSet->GetSourceHash();
+      memcpy(&data[0], &header, sizeof(PackedBlockSetHeader));
+
+      PackedBlock* packedBlocks = (PackedBlock*)&data[sizeof(PackedBlockSetHeader)];
+      for (size_t i = 0; i < blockSet->GetBlocksNumber(); i++)
+      {
+        const BlockInfo& info = blockSet->GetBlockInfo((int)i);
+        strncpy(packedBlocks[i].name, info.name.c_str(), PackedBlock::NameLength - 1);
+        for (int face = 0; face < 6; face++)
+        {
+          packedBlocks[i].textures[face] = info.textures[face];
+        }
+        packedBlocks[i].isSolid = info.isSolid;
+        packedBlocks[i].isOpaque = info.isOpaque;
+        packedBlocks[i].lightEmission = info.lightEmission;
+        packedBlocks[i].fluidSpread = info.fluidSpread;
+        packedBlocks[i].fluidDelay = info.fluidDelay;
+        packedBlocks[i].tickDelay = info.tickDelay;
+        packedBlocks[i].tickBlock = info.tickBlock;
+      }
+
+      writer.AddEntry(ResourcePackEntryType::BlockSet, name, data);
+      writer.AddEntry(ResourcePackEntryType::TextureArray, name, BakeTextureArray(blockSet));
+    }
+
+    for (const std::string& name : *fontNames_)
+    {
+      writer.AddEntry(ResourcePackEntryType::Font, name, LoadFont(name));
+    }
+
+    writer.Save(path);
+  }
+
+  void ResourceBase::SetIoService(AsyncIoService* ioService)
+  {
+    ioService_ = ioService;
   }
 
 
@@ -48,15 +167,51 @@ namespace blocks
 
   std::shared_ptr<BlockSet> ResourceBase::LoadBlockSet(std::string name)
   {
-    std::string bsDirectory = rootDirectory_ + "\\" + "BlockSets" + "\\" + name;
-    std::string bsFile = bsDirectory + "\\" + name + ".bs";
+    std::lock_guard<std::mutex> locker(blockSetsMutex_);
+
+    auto it = blockSets_.find(name);
+    if (it != blockSets_.end())
+    {
+      return it->second;
+    }
+
+    if (pack_)
+    {
+      std::shared_ptr<BlockSet> blockSet = LoadPackedBlockSet(name);
+      blockSets_[name] = blockSet;
+
+      return blockSet;
+    }
+
+    std::filesystem::path bsDirectory = std::filesystem::path(rootDirectory_) / "BlockSets" / name;
+    std::string bsFile = (bsDirectory / (name + ".bs")).string();
 
     std::string blockSetStr = blocks::readTextFile(bsFile);
     nlohmann::json resourceBaseJson = nlohmann::json::parse(blockSetStr);
     nlohmann::json blocksJson = resourceBaseJson["Blocks"];
 
-    std::shared_ptr<BlockSet> blockSet = std::make_shared<BlockSet>(resourceBaseJson["Resolution"]);
+    int texturesNumber = resourceBaseJson["TexturesNumber"];
+    std::vector<std::string> textures;
+    for (int i = 0; i < texturesNumber; i++)
+    {
+      textures.push_back((bsDirectory / (std::to_string(i) + ".png")).string());
+    }
+
+    // Any change of the block set description or its images invalidates baked caches
+    std::uint64_t sourceHash = blocks::computeHash(blockSetStr);
+    for (const std::string& texture : textures)
+    {
+      std::uintmax_t size = blocks::getFileSize(texture);
+      std::int64_t time = blocks::getLastWriteTime(texture);
+      sourceHash = blocks::computeHash(texture, sourceHash);
+      sourceHash = blocks::computeHash(&size, sizeof(size), sourceHash);
+      sourceHash = blocks::computeHash(&time, sizeof(time), sourceHash);
+    }
 
+    std::shared_ptr<BlockSet> blockSet = std::make_shared<BlockSet>(name, resourceBaseJson["Resolution"], sourceHash);
+
+    std::vector<BlockInfo> blockInfos;
+    std::vector<std::string> tickTargets;
     for (auto& [key, value] : blocksJson.items())
     {
       BlockInfo blockInfo;
@@ -69,31 +224,392 @@ namespace blocks
         blockInfo.textures[index] = value;
       }
 
-      blockSet->AddBlockInfo(blockInfo);
+      blockInfo.isSolid = value.value("Solid", true);
+      blockInfo.isOpaque = value.value("Opaque", true);
+      blockInfo.lightEmission = value.value("Light", 0);
+      blockInfo.fluidSpread = value.value("Fluid", 0);
+      blockInfo.fluidDelay = value.value("FluidDelay", 0);
+      blockInfo.tickDelay = value.value("Tick", 0);
+
+      blockInfos.push_back(blockInfo);
+      tickTargets.push_back(value.value("TickInto", ""));
     }
 
-    int texturesNumber = resourceBaseJson["TexturesNumber"];
-    for (int i = 0; i < texturesNumber; i++)
+    // Tick targets are given by name, ids follow the order of the blocks and an unknown name means air
+    for (size_t i = 0; i < blockInfos.size(); i++)
+    {
+      for (size_t target = 0; target < blockInfos.size() && !tickTargets[i].empty(); target++)
+      {
+        if (blockInfos[target].name == tickTargets[i])
+        {
+          blockInfos[i].tickBlock = (std::uint16_t)(target + 1);
+        }
+      }
+
+      blockSet->AddBlockInfo(blockInfos[i]);
+    }
+
+    for (const std::string& texture : textures)
+    {
+      blockSet->AddTexture(texture);
+    }
+
+    blockSet->CompileRegistry();
+    blockSets_[name] = blockSet;
+
+    return blockSet;
+  }
+
+
+  std::shared_ptr<BlockSet> ResourceBase::LoadPackedBlockSet(std::string name)
+  {
+    const ResourcePackEntry* entry = pack_->FindEntry(ResourcePackEntryType::BlockSet, name);
+    if (!entry || entry->size < sizeof(PackedBlockSetHeader))
+    {
+      return nullptr;
+    }
+
+    const unsigned char* data = pack_->GetEntryData(*entry);
+    const PackedBlockSetHeader* header = (const PackedBlockSetHeader*)data;
+    const PackedBlock* packedBlocks = (const PackedBlock*)(data + sizeof(PackedBlockSetHeader));
+    if (header->blocksNumber > (entry->size - sizeof(PackedBlockSetHeader)) / sizeof(PackedBlock))
+    {
+      return nullptr;
+    }
+
+    std::shared_ptr<BlockSet> blockSet = std::make_shared<BlockSet>(name, header->resolution, header->sourceHash);
+    for (std::uint32_t i = 0; i < header->blocksNumber; i++)
     {
-      blockSet->AddTexture(bsDirectory + "\\" + std::to_string(i) + ".png");
+      const PackedBlock& packedBlock = packedBlocks[i];
+
+      BlockInfo blockInfo;
+      blockInfo.name = std::string(packedBlock.name, strnlen(packedBlock.name, PackedBlock::NameLength));
+      for (int face = 0; face < 6; face++)
+      {
+        blockInfo.textures[face] = packedBlock.textures[face];
+      }
+      blockInfo.isSolid = packedBlock.isSolid != 0;
+      blockInfo.isOpaque = packedBlock.isOpaque != 0;
+      blockInfo.lightEmission = packedBlock.lightEmission;
+      blockInfo.fluidSpread = packedBlock.fluidSpread;
+      blockInfo.fluidDelay = packedBlock.fluidDelay;
+      blockInfo.tickDelay = packedBlock.tickDelay;
+      blockInfo.tickBlock = packedBlock.tickBlock;
+
+      blockSet->AddBlockInfo(blockInfo);
     }
 
+    blockSet->CompileRegistry();
+
     return blockSet;
   }
 
 
+  std::shared_ptr<std::vector<std::string>> ResourceBase::GetFontNames()
+  {
+    return fontNames_;
+  }
+
+  std::vector<unsigned char> ResourceBase::LoadFont(std::string name)
+  {
+    if (pack_)
+    {
+      const ResourcePackEntry* entry = pack_->FindEntry(ResourcePackEntryType::Font, name);
+      if (!entry)
+      {
+        return std::vector<unsigned char>();
+      }
+
+      const unsigned char* data = pack_->GetEntryData(*entry);
+      return std::vector<unsigned char>(data, data + entry->size);
+    }
+
+    auto it = fontPaths_.find(name);
+    if (it == fontPaths_.end())
+    {
+      return std::vector<unsigned char>();
+    }
+
+    return blocks::readBinaryFile(it->second);
+  }
+
+
+  TextureArray ResourceBase::LoadBlockSetTextures(std::shared_ptr<BlockSet> blockSet)
+  {
+    if (pack_)
+    {
+      return LoadPackedTextureArray(blockSet->GetName());
+    }
+
+    std::string cachePath = std::string(CACHE_DIR) + blockSet->GetName() + ".texarray";
+
+    TextureArray result = ReadTextureArrayCache(cachePath, blockSet->GetSourceHash());
+    if (result.data)
+    {
+      return result;
+    }
+
+    std::shared_ptr<std::vector<unsigned char>> baked = std::make_shared<std::vector<unsigned char>>(BakeTextureArray(blockSet));
+
+    if (!blocks::isPathExist(CACHE_DIR))
+    {
+      blocks::createDirectory(CACHE_DIR);
+    }
+    blocks::saveBinaryFile(cachePath, *baked);
+
+    result = ReadTextureArrayCache(cachePath, blockSet->GetSourceHash());
+    if (result.data)
+    {
+      return result;
+    }
+
+    // Cache directory is not writable, use baked data directly
+    TextureArrayHeader header;
+    memcpy(&header, &(*baked)[0], sizeof(TextureArrayHeader));
+
+    result.resolution = header.resolution;
+    result.layers = header.layers;
+    result.mipLevels = header.mipLevels;
+    result.data = &(*baked)[sizeof(TextureArrayHeader)];
+    result.size = header.dataSize;
+    result.storage = baked;
+
+    return result;
+  }
+
+
+  TextureArray ResourceBase::LoadPackedTextureArray(std::string name)
+  {
+    TextureArray result;
+
+    const ResourcePackEntry* entry = pack_->FindEntry(ResourcePackEntryType::TextureArray, name);
+    if (!entry || entry->size < sizeof(TextureArrayHeader))
+    {
+      return result;
+    }
+
+    const unsigned char* data = pack_->GetEntryData(*entry);
+    const TextureArrayHeader* header = (const TextureArrayHeader*)data;
+    if (header->dataSize > entry->size - sizeof(TextureArrayHeader) || !IsTextureArrayLayoutValid(*header))
+    {
+      return result;
+    }
+
+    result.resolution = header->resolution;
+    result.layers = header->layers;
+    result.mipLevels = header->mipLevels;
+    result.data = data + sizeof(TextureArrayHeader);
+    result.size = header->dataSize;
+    result.storage = pack_->GetStorage();
+
+    return result;
+  }
+
+  TextureArray ResourceBase::ReadTextureArrayCache(std::string path, std::uint64_t sourceHash)
+  {
+    TextureArray result;
+
+    if (!blocks::isPathExist(path))
+    {
+      return result;
+    }
+
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>(path);
+    if (!file->IsOpen() || file->GetSize() < sizeof(TextureArrayHeader))
+    {
+      return result;
+    }
+
+    TextureArrayHeader header;
+    memcpy(&header, file->GetData(), sizeof(TextureArrayHeader));
+    if (header.magic != TextureArrayHeader::Magic || header.version != TextureArrayHeader::Version || header.sourceHash != sourceHash ||
+      file->GetSize() != sizeof(TextureArrayHeader) + header.dataSize || !IsTextureArrayLayoutValid(header))
+    {
+      return result;
+    }
+
+    result.resolution = header.resolution;
+    result.layers = header.layers;
+    result.mipLevels = header.mipLevels;
+    result.data = file->GetData() + sizeof(TextureArrayHeader);
+    result.size = header.dataSize;
+    result.storage = file;
+
+    return result;
+  }
+
+  bool ResourceBase::IsTextureArrayLayoutValid(const TextureArrayHeader& header)
+  {
+    if (header.resolution == 0 || header.resolution > INT_MAX || header.layers == 0 || header.layers > INT_MAX ||
+      header.mipLevels != (std::uint32_t)TextureArray::GetMipLevelsNumber((int)header.resolution))
+    {
+      return false;
+    }
+
+    size_t dataSize = 0;
+    for (int level = 0; level < (int)header.mipLevels; level++)
+    {
+      dataSize += TextureArray::GetLevelSize((int)header.resolution, (int)header.layers, level);
+    }
+
+    return dataSize == header.dataSize;
+  }
+
+  std::vector<unsigned char> ResourceBase::BakeTextureArray(std::shared_ptr<BlockSet> blockSet)
+  {
+    const int resolution = blockSet->GetResolution();
+    const int layers = (int)blockSet->GetTexturesNumber();
+    const int mipLevels = TextureArray::GetMipLevelsNumber(resolution);
+
+    size_t dataSize = 0;
+    for (int level = 0; level < mipLevels; level++)
+    {
+      dataSize += TextureArray::GetLevelSize(resolution, layers, level);
+    }
+
+    std::vector<unsigned char> result(sizeof(TextureArrayHeader) + dataSize);
+
+    TextureArrayHeader header;
+    header.magic = TextureArrayHeader::Magic;
+    header.version = TextureArrayHeader::Version;
+    header.sourceHash = blockSet->GetSourceHash();
+    header.resolution = resolution;
+    header.layers = layers;
+    header.mipLevels = mipLevels;
+    header.reserved = 0;
+    header.dataSize = dataSize;
+    memcpy(&result[0], &header, sizeof(TextureArrayHeader));
+
+    unsigned char* pixels = &result[sizeof(TextureArrayHeader)];
+
+    // Base level, images of other size are resampled to block set resolution
+    std::vector<std::string> paths;
+    for (int layer = 0; layer < layers; layer++)
+    {
+      paths.push_back(blockSet->GetTexture(layer));
+    }
+    std::vector<Image> images = ReadImages(paths);
+
+    const size_t layerSize = (size_t)resolution * resolution * 4;
+    for (int layer = 0; layer < layers; layer++)
+    {
+      const Image& image = images[layer];
+      unsigned char* target = pixels + layer * layerSize;
+
+      if (image.data.empty())
+      {
+        memset(target, 0xFF, layerSize);
+        continue;
+      }
+
+      for (int y = 0; y < resolution; y++)
+      {
+        for (int x = 0; x < resolution; x++)
+        {
+          int sourceX = x * image.width / resolution;
+          int sourceY = y * image.height / resolution;
+          const unsigned char* source = &image.data[(sourceX + sourceY * image.width) * image.channels];
+          unsigned char* pixel = target + (x + y * resolution) * 4;
+
+          pixel[0] = source[0];
+          pixel[1] = image.channels > 1 ? source[1] : source[0];
+          pixel[2] = image.channels > 2 ? source[2] : source[0];
+          pixel[3] = image.channels > 3 ? source[3] : 0xFF;
+        }
+      }
+    }
+
+    // Box filtered mip chain
+    unsigned char* previousLevel = pixels;
+    for (int level = 1; level < mipLevels; level++)
+    {
+      unsigned char* currentLevel = previousLevel + TextureArray::GetLevelSize(resolution, layers, level - 1);
+      const int previousResolution = TextureArray::GetLevelResolution(resolution, level - 1);
+      const int currentResolution = TextureArray::GetLevelResolution(resolution, level);
+
+      for (int layer = 0; layer < layers; layer++)
+      {
+        const unsigned char* source = previousLevel + (size_t)layer * previousResolution * previousResolution * 4;
+        unsigned char* target = currentLevel + (size_t)layer * currentResolution * currentResolution * 4;
+
+        for (int y = 0; y < currentResolution; y++)
+        {
+          for (int x = 0; x < currentResolution; x++)
+          {
+            for (int channel = 0; channel < 4; channel++)
+            {
+              int sum =
+                source[((x * 2) + (y * 2) * previousResolution) * 4 + channel] +
+                source[((x * 2 + 1) + (y * 2) * previousResolution) * 4 + channel] +
+                source[((x * 2) + (y * 2 + 1) * previousResolution) * 4 + channel] +
+                source[((x * 2 + 1) + (y * 2 + 1) * previousResolution) * 4 + channel];
+
+              target[(x + y * currentResolution) * 4 + channel] = (unsigned char)((sum + 2) / 4);
+            }
+          }
+        }
+      }
+
+      previousLevel = currentLevel;
+    }
+
+    return result;
+  }
+
+
   Image ResourceBase::ReadImage(std::string path)
   {
     Image result;
 
-    std::vector<unsigned char> data = blocks::readBinaryFile(path);
+    MappedFile file = blocks::mapFile(path);
+    std::span<const unsigned char> data = file.GetView();
+
+    if (data.empty())
+    {
+      return result;
+    }
+
+    // Thread local flag, images may be decoded from several threads at once
+    stbi_set_flip_vertically_on_load_thread(true);
 
-    stbi_set_flip_vertically_on_load(true);
+    unsigned char* rawData = stbi_load_from_memory(data.data(), (int)data.size(), &result.width, &result.height, &result.channels, 0);
+    if (!rawData)
+    {
+      return result;
+    }
 
-    unsigned char* rawData = stbi_load_from_memory(&data[0], data.size(), &result.width, &result.height, &result.channels, 0);
     result.data = std::vector<unsigned char>(rawData, rawData + result.height * result.width * result.channels);
     stbi_image_free(rawData);
 
     return result;
   }
+
+  std::vector<Image> ResourceBase::ReadImages(const std::vector<std::string>& paths)
+  {
+    std::vector<Image> result(paths.size());
+
+    if (ioService_ == nullptr || paths.size() <= 1)
+    {
+      for (size_t i = 0; i < paths.size(); i++)
+      {
+        result[i] = ReadImage(paths[i]);
+      }
+
+      return result;
+    }
+
+    std::vector<std::future<Image>> images;
+    images.reserve(paths.size());
+    for (const std::string& path : paths)
+    {
+      images.push_back(ioService_->Submit([this, path]() { return ReadImage(path); }));
+    }
+
+    for (size_t i = 0; i < images.size(); i++)
+    {
+      result[i] = images[i].get();
+    }
+
+    return result;
+  }
 }
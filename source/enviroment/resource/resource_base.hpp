@@ -1,12 +1,17 @@
 #pragma once
 
 #include <string>
+#include <map>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "export.h"
+#include "io/async_io_service.hpp"
 #include "block_set.hpp"
 #include "resource/image.hpp"
+#include "resource/texture_array.hpp"
+#include "resource/resource_pack.hpp"
 
 
 namespace blocks
@@ -21,15 +26,45 @@ namespace blocks
     ResourceBase& operator=(ResourceBase&& other) = delete;
     ~ResourceBase();
 
-    void SetUp(std::string path);
+    // Accepts either resource base description (.rb) or compiled resource pack (.pack).
+    // Returns false when there are no usable block sets, a pack that fails its checks is not used at all.
+    bool SetUp(std::string path);
+    // Compiles everything described by the set up resource base into a single pack
+    void SavePack(std::string path);
+
+    // Images are decoded on the service threads when set, sequentially otherwise
+    void SetIoService(AsyncIoService* ioService);
 
     std::shared_ptr<std::vector<std::string>> GetBlockSetNames();
     std::shared_ptr<BlockSet> LoadBlockSet(std::string name);
 
+    std::shared_ptr<std::vector<std::string>> GetFontNames();
+    std::vector<unsigned char> LoadFont(std::string name);
+
+    // Returns all block set textures with mip chain, baked once and memory-mapped from cache afterwards
+    TextureArray LoadBlockSetTextures(std::shared_ptr<BlockSet> blockSet);
+
     Image ReadImage(std::string path);
+    // Decodes images concurrently on the I/O service, result order matches paths
+    std::vector<Image> ReadImages(const std::vector<std::string>& paths);
+
+    std::vector<unsigned char> BakeTextureArray(std::shared_ptr<BlockSet> blockSet);
 
   private:
+    bool SetUpPack(std::string path);
+    std::shared_ptr<BlockSet> LoadPackedBlockSet(std::string name);
+    TextureArray LoadPackedTextureArray(std::string name);
+    TextureArray ReadTextureArrayCache(std::string path, std::uint64_t sourceHash);
+    // Dimensions must be those of a baked array and account for exactly dataSize bytes
+    static bool IsTextureArrayLayoutValid(const TextureArrayHeader& header);
+
     std::string rootDirectory_;
     std::shared_ptr<std::vector<std::string>> blockSetPaths_;
+    std::map<std::string, std::shared_ptr<BlockSet>> blockSets_;
+    std::shared_ptr<std::vector<std::string>> fontNames_;
+    std::map<std::string, std::string> fontPaths_;
+    std::unique_ptr<ResourcePack> pack_;
+    std::mutex blockSetsMutex_;
+    AsyncIoService* ioService_ = nullptr;
   };
 }
@@ -0,0 +1,124 @@
+#include "resource_pack.hpp"
+
+#include <cstring>
+
+#include "io/file_api.hpp"
+
+
+namespace blocks
+{
+  ResourcePack::ResourcePack(std::string path)
+  {
+    file_ = std::make_shared<MappedFile>(path);
+    if (!file_->IsOpen() || file_->GetSize() < sizeof(ResourcePackHeader))
+    {
+      file_.reset();
+      return;
+    }
+
+    // Sizes are compared as remainders, so corrupted offsets can not wrap around
+    size_t fileSize = file_->GetSize();
+    const ResourcePackHeader* header = (const ResourcePackHeader*)file_->GetData();
+    if (header->magic != ResourcePackHeader::Magic || header->version != ResourcePackHeader::Version ||
+      header->indexOffset > fileSize || header->entriesNumber > (fileSize - header->indexOffset) / sizeof(ResourcePackEntry))
+    {
+      file_.reset();
+      return;
+    }
+
+    const ResourcePackEntry* entries = (const ResourcePackEntry*)(file_->GetData() + header->indexOffset);
+    for (std::uint32_t i = 0; i < header->entriesNumber; i++)
+    {
+      if (entries[i].offset > fileSize || entries[i].size > fileSize - entries[i].offset)
+      {
+        file_.reset();
+        return;
+      }
+    }
+
+    entries_ = entries;
+    entriesNumber_ = header->entriesNumber;
+  }
+
+  ResourcePack::~ResourcePack()
+  {
+
+  }
+
+
+  bool ResourcePack::IsOpen() const
+  {
+    return file_ != nullptr;
+  }
+
+  size_t ResourcePack::GetEntriesNumber() const
+  {
+    return entriesNumber_;
+  }
+
+  const ResourcePackEntry& ResourcePack::GetEntry(size_t index) const
+  {
+    return entries_[index];
+  }
+
+  const ResourcePackEntry* ResourcePack::FindEntry(ResourcePackEntryType type, const std::string& name) const
+  {
+    for (size_t i = 0; i < entriesNumber_; i++)
+    {
+      if (entries_[i].type == type && strncmp(entries_[i].name, name.c_str(), ResourcePackEntry::NameLength) == 0)
+      {
+        return &entries_[i];
+      }
+    }
+
+    return nullptr;
+  }
+
+  const unsigned char* ResourcePack::GetEntryData(const ResourcePackEntry& entry) const
+  {
+    return file_->GetData() + entry.offset;
+  }
+
+  std::shared_ptr<const MappedFile> ResourcePack::GetStorage() const
+  {
+    return file_;
+  }
+
+
+  void ResourcePackWriter::AddEntry(ResourcePackEntryType type, const std::string& name, const std::vector<unsigned char>& data)
+  {
+    ResourcePackEntry entry;
+    memset(&entry, 0, sizeof(ResourcePackEntry));
+    entry.type = type;
+    strncpy(entry.name, name.c_str(), ResourcePackEntry::NameLength - 1);
+    entry.offset = sizeof(ResourcePackHeader) + data_.size();
+    entry.size = data.size();
+    entries_.push_back(entry);
+
+    data_.insert(data_.end(), data.begin(), data.end());
+    data_.resize((data_.size() + EntryAlignment - 1) / EntryAlignment * EntryAlignment, 0);
+  }
+
+  void ResourcePackWriter::Save(std::string path)
+  {
+    ResourcePackHeader header;
+    header.magic = ResourcePackHeader::Magic;
+    header.version = ResourcePackHeader::Version;
+    header.entriesNumber = (std::uint32_t)entries_.size();
+    header.reserved = 0;
+    header.indexOffset = sizeof(ResourcePackHeader) + data_.size();
+
+    std::vector<unsigned char> result(header.indexOffset + entries_.size() * sizeof(ResourcePackEntry));
+    memcpy(&result[0], &header, sizeof(ResourcePackHeader));
+    if (!data_.empty())
+    {
+      memcpy(&result[sizeof(ResourcePackHeader)], &data_[0], data_.size());
+    }
+    if (!entries_.empty())
+    {
+      memcpy(&result[header.indexOffset], &entries_[0], entries_.size() * sizeof(ResourcePackEntry));
+    }
+
+    blocks::saveBinaryFile(path, result);
+  }
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "io/mapped_file.hpp"
+
+
+namespace blocks
+{
+  enum class ResourcePackEntryType : std::uint32_t
+  {
+    BlockSet = 1,
+    TextureArray = 2,
+    Font = 3
+  };
+
+  // Pack layout: header, entries data aligned to EntryAlignment, index of entries at indexOffset
+  struct ResourcePackHeader
+  {
+    static const std::uint32_t Magic = 0x4B415042; // "BPAK"
+    static const std::uint32_t Version = 3;
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint32_t entriesNumber;
+    std::uint32_t reserved;
+    std::uint64_t indexOffset;
+  };
+
+  struct ResourcePackEntry
+  {
+    static const size_t NameLength = 64;
+
+    ResourcePackEntryType type;
+    std::uint32_t reserved;
+    char name[NameLength];
+    std::uint64_t offset;
+    std::uint64_t size;
+  };
+
+  // Block set entry: header followed by blocksNumber records
+  struct PackedBlockSetHeader
+  {
+    std::uint32_t resolution;
+    std::uint32_t blocksNumber;
+    std::uint32_t texturesNumber;
+    std::uint32_t reserved;
+    std::uint64_t sourceHash;
+  };
+
+  struct PackedBlock
+  {
+    static const size_t NameLength = 32;
+
+    char name[NameLength];
+    std::int32_t textures[6];
+    std::uint8_t isSolid;
+    std::uint8_t isOpaque;
+    std::uint8_t lightEmission;
+    std::uint8_t fluidSpread;
+    std::uint8_t fluidDelay;
+    std::uint8_t reserved[3];
+    std::uint16_t tickDelay;
+    std::uint16_t tickBlock;
+  };
+
+
+  class ResourcePack
+  {
+  public:
+    ResourcePack(std::string path);
+    ResourcePack(const ResourcePack&) = delete;
+    ResourcePack(ResourcePack&& other) = delete;
+    ResourcePack& operator=(const ResourcePack&) = delete;
+    ResourcePack& operator=(ResourcePack&& other) = delete;
+    ~ResourcePack();
+
+    bool IsOpen() const;
+
+    size_t GetEntriesNumber() const;
+    const ResourcePackEntry& GetEntry(size_t index) const;
+    const ResourcePackEntry* FindEntry(ResourcePackEntryType type, const std::string& name) const;
+    const unsigned char* GetEntryData(const ResourcePackEntry& entry) const;
+
+    // Owner of the mapping for data handed out of the pack
+    std::shared_ptr<const MappedFile> GetStorage() const;
+
+  private:
+    std::shared_ptr<MappedFile> file_;
+    const ResourcePackEntry* entries_ = nullptr;
+    size_t entriesNumber_ = 0;
+  };
+
+
+  class ResourcePackWriter
+  {
+  public:
+    static const size_t EntryAlignment = 16;
+
+    void AddEntry(ResourcePackEntryType type, const std::string& name, const std::vector<unsigned char>& data);
+    void Save(std::string path);
+
+  private:
+    std::vector<ResourcePackEntry> entries_;
+    std::vector<unsigned char> data_;
+  };
+}
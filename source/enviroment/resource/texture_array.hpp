@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+
+namespace blocks
+{
+  // On-disk layout: header followed by RGBA8 pixels of every mip level, each level holds all layers one after another
+  struct TextureArrayHeader
+  {
+    static const std::uint32_t Magic = 0x52415442; // "BTAR"
+    static const std::uint32_t Version = 1;
+
+    std::uint32_t magic;
+    std::uint32_t version;
+    std::uint64_t sourceHash;
+    std::uint32_t resolution;
+    std::uint32_t layers;
+    std::uint32_t mipLevels;
+    std::uint32_t reserved;
+    std::uint64_t dataSize;
+  };
+
+  struct TextureArray
+  {
+    int resolution = 0;
+    int layers = 0;
+    int mipLevels = 0;
+    const unsigned char* data = nullptr;
+    size_t size = 0;
+
+    // Keeps memory behind data alive, either mapped cache file or baked buffer
+    std::shared_ptr<const void> storage;
+
+    static int GetLevelResolution(int resolution, int level)
+    {
+      return std::max(resolution >> level, 1);
+    }
+
+    static size_t GetLevelSize(int resolution, int layers, int level)
+    {
+      size_t levelResolution = GetLevelResolution(resolution, level);
+      return levelResolution * levelResolution * 4 * layers;
+    }
+
+    static int GetMipLevelsNumber(int resolution)
+    {
+      int levels = 1;
+      while ((resolution >> levels) > 0)
+      {
+        levels++;
+      }
+
+      return levels;
+    }
+
+    size_t GetLevelOffset(int level) const
+    {
+      size_t offset = 0;
+      for (int i = 0; i < level; i++)
+      {
+        offset += GetLevelSize(resolution, layers, i);
+      }
+
+      return offset;
+    }
+  };
+}
@@ -4,6 +4,7 @@
 #include "resourceConfig.h"
 
 #include "environment.hpp"
+#include "io/file_api.hpp"
 #include "game.hpp"
 
 const unsigned int SCR_WIDTH = 1280;
@@ -23,7 +24,11 @@ int main()
 
   blocks::Environment::Init();
 
-  blocks::Environment::GetResource().SetUp(RESOURCE_BASE_PATH);
+  // Invalid or outdated packs fall back to the resource base they were compiled from
+  if (!blocks::Environment::GetResource().SetUp(RESOURCE_PACK_PATH))
+  {
+    blocks::Environment::GetResource().SetUp(RESOURCE_BASE_PATH);
+  }
 
   RunGame();
 
@@ -6,4 +6,23 @@
 namespace blocks
 {
   typedef std::uint32_t Block;
+
+  // Low bits hold the block type indexed by the registry, high bits keep per block state such as a fluid level
+  static const Block BlockTypeMask = 0xFFFF;
+  static const int BlockStateShift = 16;
+
+  inline Block GetBlockType(Block block)
+  {
+    return block & BlockTypeMask;
+  }
+
+  inline std::uint32_t GetBlockState(Block block)
+  {
+    return block >> BlockStateShift;
+  }
+
+  inline Block MakeBlock(Block type, std::uint32_t state)
+  {
+    return type | (state << BlockStateShift);
+  }
 }
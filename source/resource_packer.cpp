@@ -0,0 +1,24 @@
+#include <iostream>
+
+#include "io/async_io_service.hpp"
+#include "resource/resource_base.hpp"
+
+
+int main(int argc, char** argv)
+{
+  if (argc < 3)
+  {
+    std::cout << "Usage: BlocksResourcePacker <resource base .rb> <output .pack>" << std::endl;
+    return 1;
+  }
+
+  blocks::AsyncIoService ioService;
+  blocks::ResourceBase resourceBase;
+  resourceBase.SetIoService(&ioService);
+  resourceBase.SetUp(argv[1]);
+  resourceBase.SavePack(argv[2]);
+
+  std::cout << "Resource pack saved to " << argv[2] << std::endl;
+
+  return 0;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+
+namespace blocks
+{
+  // Hierarchical timing wheel, level L has 64 slots of 64^L ticks each. An item sits in the lowest level whose
+  // span still holds its due tick and drops one level whenever the wheel enters its slot, so advancing a tick
+  // only touches items that are due or cascading, never everything that is scheduled.
+  template <typename T>
+  class TimingWheel
+  {
+  public:
+    static const int SlotBits = 6;
+    static const size_t SlotsNumber = 1 << SlotBits;
+    static const int LevelsNumber = 4;
+
+    TimingWheel(std::uint64_t tick = 0) : tick_(tick)
+    {
+
+    }
+
+    std::uint64_t GetTick() const
+    {
+      return tick_;
+    }
+
+    size_t GetSize() const
+    {
+      return size_;
+    }
+
+    // Ticks that are not in the future fire on the next advance
+    void Schedule(std::uint64_t dueTick, T item)
+    {
+      Insert(Entry{ std::max(dueTick, tick_ + 1), std::move(item) });
+      size_++;
+    }
+
+    // Moves to the next tick and appends items due on it
+    void Advance(std::vector<T>& dueItems)
+    {
+      tick_++;
+
+      // Higher levels cascade first, their items may land in the lower slots entered on the same tick
+      int topLevel = 0;
+      while (topLevel + 1 < LevelsNumber && (tick_ & ((1ull << (SlotBits * (topLevel + 1))) - 1)) == 0)
+      {
+        topLevel++;
+      }
+      for (int level = topLevel; level > 0; level--)
+      {
+        std::vector<Entry> entries = std::move(slots_[level][GetSlot(tick_, level)]);
+        slots_[level][GetSlot(tick_, level)].clear();
+        for (Entry& entry : entries)
+        {
+          Insert(std::move(entry));
+        }
+      }
+
+      std::vector<Entry>& slot = slots_[0][GetSlot(tick_, 0)];
+      for (Entry& entry : slot)
+      {
+        dueItems.push_back(std::move(entry.item));
+      }
+      size_ -= slot.size();
+      slot.clear();
+    }
+
+  private:
+    struct Entry
+    {
+      std::uint64_t dueTick;
+      T item;
+    };
+
+    static size_t GetSlot(std::uint64_t tick, int level)
+    {
+      return (size_t)((tick >> (SlotBits * level)) & (SlotsNumber - 1));
+    }
+
+    void Insert(Entry&& entry)
+    {
+      // Lowest level where the due tick and the current one only differ inside the level span,
+      // ticks beyond the top level wait in its slots and are placed again when cascaded
+      int level = 0;
+      while (level + 1 < LevelsNumber && (entry.dueTick >> (SlotBits * (level + 1))) != (tick_ >> (SlotBits * (level + 1))))
+      {
+        level++;
+      }
+
+      slots_[level][GetSlot(entry.dueTick, level)].push_back(std::move(entry));
+    }
+
+    std::vector<Entry> slots_[LevelsNumber][SlotsNumber];
+    std::uint64_t tick_;
+    size_t size_ = 0;
+  };
+}
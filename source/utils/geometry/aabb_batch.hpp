@@ -0,0 +1,56 @@
+#pragma once
+
+#include <vector>
+
+#include "aabb.hpp"
+#include "memory/aligned_allocator.hpp"
+
+
+namespace blocks
+{
+  // Boxes in structure of arrays layout, each coordinate is a separate aligned stream for SIMD kernels
+  struct AABBBatch
+  {
+    std::vector<float, AlignedAllocator<float>> lowX;
+    std::vector<float, AlignedAllocator<float>> lowY;
+    std::vector<float, AlignedAllocator<float>> lowZ;
+    std::vector<float, AlignedAllocator<float>> highX;
+    std::vector<float, AlignedAllocator<float>> highY;
+    std::vector<float, AlignedAllocator<float>> highZ;
+
+    size_t GetSize() const
+    {
+      return lowX.size();
+    }
+
+    void Reserve(size_t size)
+    {
+      lowX.reserve(size);
+      lowY.reserve(size);
+      lowZ.reserve(size);
+      highX.reserve(size);
+      highY.reserve(size);
+      highZ.reserve(size);
+    }
+
+    void Add(const AABB& bounds)
+    {
+      lowX.push_back(bounds.low.x);
+      lowY.push_back(bounds.low.y);
+      lowZ.push_back(bounds.low.z);
+      highX.push_back(bounds.high.x);
+      highY.push_back(bounds.high.y);
+      highZ.push_back(bounds.high.z);
+    }
+
+    void Clear()
+    {
+      lowX.clear();
+      lowY.clear();
+      lowZ.clear();
+      highX.clear();
+      highY.clear();
+      highZ.clear();
+    }
+  };
+}
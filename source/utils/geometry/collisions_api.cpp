@@ -1,8 +1,65 @@
 #include "collisions_api.hpp"
 
+#include <bit>
+#include <cfloat>
+#include <cmath>
+
+#include "simd_config.hpp"
+
 
 namespace blocks
 {
+  namespace
+  {
+    // Slabs of a ray lying in a box plane give 0 * inf = NaN. The batched test must treat them like the single one,
+    // which takes per axis minimum and maximum as glm does (a NaN first operand wins) and combines axes with
+    // fmax and fmin, which ignore a NaN operand.
+#if defined(BLOCKS_SIMD_AVX2)
+    __m256 MinPair(__m256 t0, __m256 t1)
+    {
+      return _mm256_min_ps(t1, t0);
+    }
+
+    __m256 MaxPair(__m256 t0, __m256 t1)
+    {
+      return _mm256_max_ps(t1, t0);
+    }
+
+    __m256 MinNumber(__m256 a, __m256 b)
+    {
+      return _mm256_blendv_ps(_mm256_min_ps(b, a), b, _mm256_cmp_ps(a, a, _CMP_UNORD_Q));
+    }
+
+    __m256 MaxNumber(__m256 a, __m256 b)
+    {
+      return _mm256_blendv_ps(_mm256_max_ps(b, a), b, _mm256_cmp_ps(a, a, _CMP_UNORD_Q));
+    }
+#elif defined(BLOCKS_SIMD_SSE)
+    __m128 MinPair(__m128 t0, __m128 t1)
+    {
+      return _mm_min_ps(t1, t0);
+    }
+
+    __m128 MaxPair(__m128 t0, __m128 t1)
+    {
+      return _mm_max_ps(t1, t0);
+    }
+
+    __m128 MinNumber(__m128 a, __m128 b)
+    {
+      __m128 isNan = _mm_cmpunord_ps(a, a);
+      return _mm_or_ps(_mm_and_ps(isNan, b), _mm_andnot_ps(isNan, _mm_min_ps(b, a)));
+    }
+
+    __m128 MaxNumber(__m128 a, __m128 b)
+    {
+      __m128 isNan = _mm_cmpunord_ps(a, a);
+      return _mm_or_ps(_mm_and_ps(isNan, b), _mm_andnot_ps(isNan, _mm_max_ps(b, a)));
+    }
+#endif
+  }
+
+
   RayIntersectionPoint CheckCollision(const Ray& ray, const AABB& bounds)
   {
     glm::vec3 invD = glm::vec3(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
@@ -32,4 +89,140 @@ namespace blocks
       bounds1.high.y >= bounds2.low.y && bounds2.high.y >= bounds1.low.y &&
       bounds1.high.z >= bounds2.low.z && bounds2.high.z >= bounds1.low.z;
   }
+
+
+  void CheckCollisions(const Ray& ray, const AABBBatch& boxes, float* distances)
+  {
+    glm::vec3 invD = glm::vec3(1.0f / ray.direction.x, 1.0f / ray.direction.y, 1.0f / ray.direction.z);
+    size_t size = boxes.GetSize();
+    size_t i = 0;
+
+#if defined(BLOCKS_SIMD_AVX2)
+    __m256 originX = _mm256_set1_ps(ray.origin.x);
+    __m256 originY = _mm256_set1_ps(ray.origin.y);
+    __m256 originZ = _mm256_set1_ps(ray.origin.z);
+    __m256 invDX = _mm256_set1_ps(invD.x);
+    __m256 invDY = _mm256_set1_ps(invD.y);
+    __m256 invDZ = _mm256_set1_ps(invD.z);
+    __m256 miss = _mm256_set1_ps(FLT_MAX);
+    for (; i + 8 <= size; i += 8)
+    {
+      __m256 t0X = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(&boxes.lowX[i]), originX), invDX);
+      __m256 t1X = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(&boxes.highX[i]), originX), invDX);
+      __m256 t0Y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(&boxes.lowY[i]), originY), invDY);
+      __m256 t1Y = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(&boxes.highY[i]), originY), invDY);
+      __m256 t0Z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(&boxes.lowZ[i]), originZ), invDZ);
+      __m256 t1Z = _mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(&boxes.highZ[i]), originZ), invDZ);
+
+      __m256 tmin = MaxNumber(MinPair(t0X, t1X), MaxNumber(MinPair(t0Y, t1Y), MinPair(t0Z, t1Z)));
+      __m256 tmax = MinNumber(MaxPair(t0X, t1X), MinNumber(MaxPair(t0Y, t1Y), MaxPair(t0Z, t1Z)));
+
+      _mm256_storeu_ps(distances + i, _mm256_blendv_ps(miss, tmin, _mm256_cmp_ps(tmin, tmax, _CMP_LT_OQ)));
+    }
+#elif defined(BLOCKS_SIMD_SSE)
+    __m128 originX = _mm_set1_ps(ray.origin.x);
+    __m128 originY = _mm_set1_ps(ray.origin.y);
+    __m128 originZ = _mm_set1_ps(ray.origin.z);
+    __m128 invDX = _mm_set1_ps(invD.x);
+    __m128 invDY = _mm_set1_ps(invD.y);
+    __m128 invDZ = _mm_set1_ps(invD.z);
+    __m128 miss = _mm_set1_ps(FLT_MAX);
+    for (; i + 4 <= size; i += 4)
+    {
+      __m128 t0X = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.lowX[i]), originX), invDX);
+      __m128 t1X = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.highX[i]), originX), invDX);
+      __m128 t0Y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.lowY[i]), originY), invDY);
+      __m128 t1Y = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.highY[i]), originY), invDY);
+      __m128 t0Z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.lowZ[i]), originZ), invDZ);
+      __m128 t1Z = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(&boxes.highZ[i]), originZ), invDZ);
+
+      __m128 tmin = MaxNumber(MinPair(t0X, t1X), MaxNumber(MinPair(t0Y, t1Y), MinPair(t0Z, t1Z)));
+      __m128 tmax = MinNumber(MaxPair(t0X, t1X), MinNumber(MaxPair(t0Y, t1Y), MaxPair(t0Z, t1Z)));
+
+      // No blend before SSE4.1, select through the comparison mask
+      __m128 hit = _mm_cmplt_ps(tmin, tmax);
+      _mm_storeu_ps(distances + i, _mm_or_ps(_mm_and_ps(hit, tmin), _mm_andnot_ps(hit, miss)));
+    }
+#endif
+
+    // Scalar tail, or everything when no SIMD is available
+    for (; i < size; i++)
+    {
+      float t0X = (boxes.lowX[i] - ray.origin.x) * invD.x;
+      float t1X = (boxes.highX[i] - ray.origin.x) * invD.x;
+      float t0Y = (boxes.lowY[i] - ray.origin.y) * invD.y;
+      float t1Y = (boxes.highY[i] - ray.origin.y) * invD.y;
+      float t0Z = (boxes.lowZ[i] - ray.origin.z) * invD.z;
+      float t1Z = (boxes.highZ[i] - ray.origin.z) * invD.z;
+
+      float tmin = fmax(glm::min(t0X, t1X), fmax(glm::min(t0Y, t1Y), glm::min(t0Z, t1Z)));
+      float tmax = fmin(glm::max(t0X, t1X), fmin(glm::max(t0Y, t1Y), glm::max(t0Z, t1Z)));
+
+      distances[i] = tmin < tmax ? tmin : FLT_MAX;
+    }
+  }
+
+  size_t CheckCollisions(const AABB& bounds, const AABBBatch& boxes, bool* results)
+  {
+    size_t size = boxes.GetSize();
+    size_t hitsNumber = 0;
+    size_t i = 0;
+
+#if defined(BLOCKS_SIMD_AVX2)
+    __m256 lowX = _mm256_set1_ps(bounds.low.x);
+    __m256 lowY = _mm256_set1_ps(bounds.low.y);
+    __m256 lowZ = _mm256_set1_ps(bounds.low.z);
+    __m256 highX = _mm256_set1_ps(bounds.high.x);
+    __m256 highY = _mm256_set1_ps(bounds.high.y);
+    __m256 highZ = _mm256_set1_ps(bounds.high.z);
+    for (; i + 8 <= size; i += 8)
+    {
+      __m256 hit = _mm256_and_ps(
+        _mm256_and_ps(_mm256_cmp_ps(highX, _mm256_load_ps(&boxes.lowX[i]), _CMP_GE_OQ), _mm256_cmp_ps(_mm256_load_ps(&boxes.highX[i]), lowX, _CMP_GE_OQ)),
+        _mm256_and_ps(_mm256_cmp_ps(highY, _mm256_load_ps(&boxes.lowY[i]), _CMP_GE_OQ), _mm256_cmp_ps(_mm256_load_ps(&boxes.highY[i]), lowY, _CMP_GE_OQ)));
+      hit = _mm256_and_ps(hit,
+        _mm256_and_ps(_mm256_cmp_ps(highZ, _mm256_load_ps(&boxes.lowZ[i]), _CMP_GE_OQ), _mm256_cmp_ps(_mm256_load_ps(&boxes.highZ[i]), lowZ, _CMP_GE_OQ)));
+
+      int mask = _mm256_movemask_ps(hit);
+      for (int lane = 0; lane < 8; lane++)
+      {
+        results[i + lane] = (mask >> lane) & 1;
+      }
+      hitsNumber += std::popcount((unsigned int)mask);
+    }
+#elif defined(BLOCKS_SIMD_SSE)
+    __m128 lowX = _mm_set1_ps(bounds.low.x);
+    __m128 lowY = _mm_set1_ps(bounds.low.y);
+    __m128 lowZ = _mm_set1_ps(bounds.low.z);
+    __m128 highX = _mm_set1_ps(bounds.high.x);
+    __m128 highY = _mm_set1_ps(bounds.high.y);
+    __m128 highZ = _mm_set1_ps(bounds.high.z);
+    for (; i + 4 <= size; i += 4)
+    {
+      __m128 hit = _mm_and_ps(
+        _mm_and_ps(_mm_cmpge_ps(highX, _mm_load_ps(&boxes.lowX[i])), _mm_cmpge_ps(_mm_load_ps(&boxes.highX[i]), lowX)),
+        _mm_and_ps(_mm_cmpge_ps(highY, _mm_load_ps(&boxes.lowY[i])), _mm_cmpge_ps(_mm_load_ps(&boxes.highY[i]), lowY)));
+      hit = _mm_and_ps(hit,
+        _mm_and_ps(_mm_cmpge_ps(highZ, _mm_load_ps(&boxes.lowZ[i])), _mm_cmpge_ps(_mm_load_ps(&boxes.highZ[i]), lowZ)));
+
+      int mask = _mm_movemask_ps(hit);
+      for (int lane = 0; lane < 4; lane++)
+      {
+        results[i + lane] = (mask >> lane) & 1;
+      }
+      hitsNumber += std::popcount((unsigned int)mask);
+    }
+#endif
+
+    for (; i < size; i++)
+    {
+      results[i] =
+        bounds.high.x >= boxes.lowX[i] && boxes.highX[i] >= bounds.low.x &&
+        bounds.high.y >= boxes.lowY[i] && boxes.highY[i] >= bounds.low.y &&
+        bounds.high.z >= boxes.lowZ[i] && boxes.highZ[i] >= bounds.low.z;
+      hitsNumber += results[i];
+    }
+
+    return hitsNumber;
+  }
 }
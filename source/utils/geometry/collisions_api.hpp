@@ -1,6 +1,7 @@
 #pragma once
 
 #include "aabb.hpp"
+#include "aabb_batch.hpp"
 #include "ray.hpp"
 #include "ray_intersection_point.hpp"
 
@@ -9,4 +10,10 @@ namespace blocks
 {
   RayIntersectionPoint CheckCollision(const Ray& ray, const AABB& bounds);
   bool CheckCollision(const AABB& bounds1, const AABB& bounds2);
+
+  // Batched versions of the tests above, distances and results must hold boxes.GetSize() elements.
+  // Misses get FLT_MAX distance, same as the single box test.
+  void CheckCollisions(const Ray& ray, const AABBBatch& boxes, float* distances);
+  // Returns the number of boxes intersecting bounds
+  size_t CheckCollisions(const AABB& bounds, const AABBBatch& boxes, bool* results);
 }
@@ -0,0 +1,25 @@
+#include "hash_api.hpp"
+
+
+namespace blocks
+{
+  std::uint64_t computeHash(const void* data, size_t size, std::uint64_t seed)
+  {
+    // FNV-1a, stable between runs and platforms so it can be stored in cache files
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    std::uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++)
+    {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+
+    return hash;
+  }
+
+  std::uint64_t computeHash(std::string_view str, std::uint64_t seed)
+  {
+    return computeHash(str.data(), str.size(), seed);
+  }
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+
+namespace blocks
+{
+  static const std::uint64_t DefaultHashSeed = 14695981039346656037ull;
+
+  std::uint64_t computeHash(const void* data, size_t size, std::uint64_t seed = DefaultHashSeed);
+  std::uint64_t computeHash(std::string_view str, std::uint64_t seed = DefaultHashSeed);
+}
@@ -0,0 +1,94 @@
+#include "async_io_service.hpp"
+
+#include <algorithm>
+
+
+namespace blocks
+{
+  AsyncIoService::AsyncIoService(size_t threadsNumber) : threadsNumber_(threadsNumber)
+  {
+    if (threadsNumber_ == 0)
+    {
+      threadsNumber_ = std::max(std::thread::hardware_concurrency(), 2u);
+    }
+  }
+
+  AsyncIoService::~AsyncIoService()
+  {
+    Stop();
+  }
+
+
+  size_t AsyncIoService::GetThreadsNumber() const
+  {
+    return threadsNumber_;
+  }
+
+
+  void AsyncIoService::Stop()
+  {
+    std::vector<std::thread> threads;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      isStopping_ = true;
+      threads.swap(threads_);
+    }
+    condition_.notify_all();
+
+    // Workers leave only once the queue is drained
+    for (std::thread& thread : threads)
+    {
+      thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    isStopping_ = false;
+  }
+
+
+  void AsyncIoService::Enqueue(std::function<void()> task)
+  {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+
+      if (isStopping_)
+      {
+        // Pool is shutting down, run on the caller
+        lock.unlock();
+        task();
+        return;
+      }
+
+      tasks_.push(std::move(task));
+
+      if (threads_.empty())
+      {
+        for (size_t i = 0; i < threadsNumber_; i++)
+        {
+          threads_.emplace_back(&AsyncIoService::RunWorker, this);
+        }
+      }
+    }
+    condition_.notify_one();
+  }
+
+  void AsyncIoService::RunWorker()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+      condition_.wait(lock, [this] { return isStopping_ || !tasks_.empty(); });
+      if (tasks_.empty())
+      {
+        return;
+      }
+
+      std::function<void()> task = std::move(tasks_.front());
+      tasks_.pop();
+
+      lock.unlock();
+      task();
+      lock.lock();
+    }
+  }
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace blocks
+{
+  // Pool of I/O threads, tasks are queued in submission order and report results through futures.
+  // Threads are started on the first submit and joined by Stop.
+  class AsyncIoService
+  {
+  public:
+    AsyncIoService(size_t threadsNumber = 0);
+    AsyncIoService(const AsyncIoService&) = delete;
+    AsyncIoService(AsyncIoService&& other) = delete;
+    AsyncIoService& operator=(const AsyncIoService&) = delete;
+    AsyncIoService& operator=(AsyncIoService&& other) = delete;
+    ~AsyncIoService();
+
+    size_t GetThreadsNumber() const;
+
+    template<typename Function>
+    std::future<std::invoke_result_t<Function>> Submit(Function function);
+
+    // Runs the queued tasks to completion and joins the threads
+    void Stop();
+
+  private:
+    void Enqueue(std::function<void()> task);
+    void RunWorker();
+
+    size_t threadsNumber_;
+    bool isStopping_ = false;
+    std::queue<std::function<void()>> tasks_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable condition_;
+  };
+
+
+  template<typename Function>
+  std::future<std::invoke_result_t<Function>> AsyncIoService::Submit(Function function)
+  {
+    // std::function needs a copyable target, packaged_task is move only
+    auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Function>()>>(std::move(function));
+    std::future<std::invoke_result_t<Function>> result = task->get_future();
+
+    Enqueue([task]() { (*task)(); });
+
+    return result;
+  }
+}
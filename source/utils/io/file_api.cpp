@@ -4,6 +4,15 @@
 #include <sstream>
 #include <filesystem>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 
 namespace blocks
 {
@@ -27,6 +36,22 @@ namespace blocks
     return paths;
   }
 
+  std::uintmax_t getFileSize(std::string path)
+  {
+    std::error_code error;
+    std::uintmax_t size = std::filesystem::file_size(std::filesystem::path(path), error);
+
+    return error ? 0 : size;
+  }
+
+  std::int64_t getLastWriteTime(std::string path)
+  {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(std::filesystem::path(path), error);
+
+    return error ? 0 : time.time_since_epoch().count();
+  }
+
 
   void createDirectory(std::string path)
   {
@@ -34,21 +59,17 @@ namespace blocks
   }
 
 
-  std::vector<unsigned char> readBinaryFile(std::string path)
+  MappedFile mapFile(std::string path)
   {
-    std::ifstream inputStream;
-    std::vector<unsigned char> result;
-
-    //input.exceptions(std::ifstream::eofbit | std::ifstream::failbit | std::ifstream::badbit);
+    return MappedFile(path);
+  }
 
-    inputStream.open(path, std::ios::in | std::ios::binary);
-    if (inputStream)
-    {
-      result = std::vector<unsigned char>(std::istreambuf_iterator<char>(inputStream), {});
-    }
-    inputStream.close();
+  std::vector<unsigned char> readBinaryFile(std::string path)
+  {
+    MappedFile file(path);
+    std::span<const unsigned char> view = file.GetView();
 
-    return result;
+    return std::vector<unsigned char>(view.begin(), view.end());
   }
 
   std::string readTextFile(std::string path)
@@ -70,30 +91,77 @@ namespace blocks
   }
 
 
-  void saveBinaryFile(std::string path, std::vector<unsigned char> data)
+  static void saveFileAtomically(const std::string& path, const char* data, size_t size, std::ios::openmode mode)
   {
+    std::string tempPath = path + ".tmp";
+
     std::ofstream outputStream;
-    std::string result;
+    outputStream.open(tempPath, mode);
+    if (!outputStream)
+    {
+      return;
+    }
 
-    outputStream.open(path, std::ios::out);
-    if (outputStream)
+    if (size != 0)
     {
-      outputStream.write((const char*)(&data[0]), data.size());
+      outputStream.write(data, size);
     }
     outputStream.close();
+
+    if (!outputStream || !syncFile(tempPath))
+    {
+      removePath(tempPath);
+      return;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(std::filesystem::path(tempPath), std::filesystem::path(path), error);
+    if (error)
+    {
+      removePath(tempPath);
+      return;
+    }
+
+#ifndef _WIN32
+    // Rename itself is durable only after the directory entry is synced
+    std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    syncFile(directory.empty() ? "." : directory.string());
+#endif
+  }
+
+  void saveBinaryFile(std::string path, std::vector<unsigned char> data)
+  {
+    saveFileAtomically(path, (const char*)data.data(), data.size(), std::ios::out | std::ios::binary);
   }
 
   void saveTextFile(std::string path, std::string str)
   {
-    std::ofstream outputStream;
-    std::string result;
+    saveFileAtomically(path, str.data(), str.size(), std::ios::out);
+  }
 
-    outputStream.open(path, std::ios::out);
-    if (outputStream)
+  bool syncFile(std::string path)
+  {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
     {
-      outputStream << str;
+      return false;
     }
-    outputStream.close();
+
+    bool result = FlushFileBuffers(file) != 0;
+    CloseHandle(file);
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+      return false;
+    }
+
+    bool result = fsync(file) == 0;
+    close(file);
+#endif
+
+    return result;
   }
 
 
@@ -101,4 +169,10 @@ namespace blocks
   {
     std::filesystem::remove(std::filesystem::path(path));
   }
+
+  void removeDirectory(std::string path)
+  {
+    std::error_code error;
+    std::filesystem::remove_all(std::filesystem::path(path), error);
+  }
 }
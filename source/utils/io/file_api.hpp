@@ -1,21 +1,32 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "mapped_file.hpp"
+
 
 namespace blocks
 {
   bool isPathExist(std::string path);
   std::vector<std::string> getFilesInDirectory(std::string path);
+  std::uintmax_t getFileSize(std::string path);
+  std::int64_t getLastWriteTime(std::string path);
 
   void createDirectory(std::string path);
 
+  // Zero-copy read, the view stays valid while the returned file is alive
+  MappedFile mapFile(std::string path);
   std::vector<unsigned char> readBinaryFile(std::string path);
   std::string readTextFile(std::string path);
 
+  // Writes to a temporary file, syncs it and renames it over the target, so readers see either the old or the new file
   void saveBinaryFile(std::string path, std::vector<unsigned char> data);
   void saveTextFile(std::string path, std::string str);
+  // Flushes file contents from the OS cache to stable storage
+  bool syncFile(std::string path);
 
   void removePath(std::string path);
+  void removeDirectory(std::string path);
 }
@@ -0,0 +1,147 @@
+#include "mapped_file.hpp"
+
+#include <utility>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace blocks
+{
+  MappedFile::MappedFile(std::string path)
+  {
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      return;
+    }
+    fileHandle_ = file;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+      Release();
+      return;
+    }
+
+    mappingHandle_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle_ == nullptr)
+    {
+      Release();
+      return;
+    }
+
+    data_ = (const unsigned char*)MapViewOfFile(mappingHandle_, FILE_MAP_READ, 0, 0, 0);
+    if (data_ == nullptr)
+    {
+      Release();
+      return;
+    }
+    size_ = (size_t)size.QuadPart;
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+    {
+      return;
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) == 0 && fileStat.st_size > 0)
+    {
+      void* data = mmap(nullptr, fileStat.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+      if (data != MAP_FAILED)
+      {
+        data_ = (const unsigned char*)data;
+        size_ = (size_t)fileStat.st_size;
+      }
+    }
+
+    // Mapping stays valid after the descriptor is closed
+    close(file);
+#endif
+  }
+
+  MappedFile::MappedFile(MappedFile&& other)
+  {
+    *this = std::move(other);
+  }
+
+  MappedFile& MappedFile::operator=(MappedFile&& other)
+  {
+    if (this != &other)
+    {
+      Release();
+      std::swap(data_, other.data_);
+      std::swap(size_, other.size_);
+#ifdef _WIN32
+      std::swap(fileHandle_, other.fileHandle_);
+      std::swap(mappingHandle_, other.mappingHandle_);
+#endif
+    }
+
+    return *this;
+  }
+
+  MappedFile::~MappedFile()
+  {
+    Release();
+  }
+
+
+  bool MappedFile::IsOpen() const
+  {
+    return data_ != nullptr;
+  }
+
+  const unsigned char* MappedFile::GetData() const
+  {
+    return data_;
+  }
+
+  size_t MappedFile::GetSize() const
+  {
+    return size_;
+  }
+
+  std::span<const unsigned char> MappedFile::GetView() const
+  {
+    return std::span<const unsigned char>(data_, size_);
+  }
+
+
+  void MappedFile::Release()
+  {
+#ifdef _WIN32
+    if (data_)
+    {
+      UnmapViewOfFile(data_);
+    }
+    if (mappingHandle_)
+    {
+      CloseHandle(mappingHandle_);
+    }
+    if (fileHandle_)
+    {
+      CloseHandle(fileHandle_);
+    }
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+#else
+    if (data_)
+    {
+      munmap((void*)data_, size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
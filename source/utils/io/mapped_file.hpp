@@ -0,0 +1,35 @@
+#pragma once
+
+#include <span>
+#include <string>
+
+
+namespace blocks
+{
+  // Read-only view of the whole file mapped into memory
+  class MappedFile
+  {
+  public:
+    MappedFile(std::string path);
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other);
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile& operator=(MappedFile&& other);
+    ~MappedFile();
+
+    bool IsOpen() const;
+    const unsigned char* GetData() const;
+    size_t GetSize() const;
+    std::span<const unsigned char> GetView() const;
+
+  private:
+    void Release();
+
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+  };
+}
@@ -0,0 +1,162 @@
+#include "writable_mapped_file.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace blocks
+{
+  WritableMappedFile::WritableMappedFile(std::string path, size_t size)
+  {
+    if (size == 0)
+    {
+      return;
+    }
+
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+      return;
+    }
+    fileHandle_ = file;
+
+    // Mapping larger than the file extends it with zeros
+    LARGE_INTEGER mappingSize;
+    mappingSize.QuadPart = (LONGLONG)size;
+    mappingHandle_ = CreateFileMappingA(file, nullptr, PAGE_READWRITE, mappingSize.HighPart, mappingSize.LowPart, nullptr);
+    if (mappingHandle_ == nullptr)
+    {
+      Release();
+      return;
+    }
+
+    data_ = (unsigned char*)MapViewOfFile(mappingHandle_, FILE_MAP_WRITE, 0, 0, size);
+    if (data_ == nullptr)
+    {
+      Release();
+      return;
+    }
+    size_ = size;
+#else
+    int file = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0)
+    {
+      return;
+    }
+
+    struct stat fileStat;
+    if (fstat(file, &fileStat) == 0 && ((size_t)fileStat.st_size >= size || ftruncate(file, (off_t)size) == 0))
+    {
+      void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+      if (data != MAP_FAILED)
+      {
+        data_ = (unsigned char*)data;
+        size_ = size;
+      }
+    }
+
+    // Mapping stays valid after the descriptor is closed
+    close(file);
+#endif
+  }
+
+  WritableMappedFile::~WritableMappedFile()
+  {
+    Release();
+  }
+
+
+  bool WritableMappedFile::IsOpen() const
+  {
+    return data_ != nullptr;
+  }
+
+  unsigned char* WritableMappedFile::GetData() const
+  {
+    return data_;
+  }
+
+  size_t WritableMappedFile::GetSize() const
+  {
+    return size_;
+  }
+
+
+  bool WritableMappedFile::Flush()
+  {
+    if (data_ == nullptr)
+    {
+      return false;
+    }
+
+#ifdef _WIN32
+    return FlushViewOfFile(data_, 0) && FlushFileBuffers(fileHandle_);
+#else
+    return msync(data_, size_, MS_SYNC) == 0;
+#endif
+  }
+
+  void WritableMappedFile::Advise(size_t offset, size_t size, MappingAdvice advice)
+  {
+    if (data_ == nullptr || offset >= size_)
+    {
+      return;
+    }
+
+    size = offset + size > size_ ? size_ - offset : size;
+
+#ifdef _WIN32
+    if (advice == MappingAdvice::WillNeed)
+    {
+      WIN32_MEMORY_RANGE_ENTRY range;
+      range.VirtualAddress = data_ + offset;
+      range.NumberOfBytes = size;
+      PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+    }
+    else
+    {
+      // Unlocking pages that are not locked trims them from the working set
+      VirtualUnlock(data_ + offset, size);
+    }
+#else
+    madvise(data_ + offset, size, advice == MappingAdvice::WillNeed ? MADV_WILLNEED : MADV_DONTNEED);
+#endif
+  }
+
+
+  void WritableMappedFile::Release()
+  {
+#ifdef _WIN32
+    if (data_)
+    {
+      UnmapViewOfFile(data_);
+    }
+    if (mappingHandle_)
+    {
+      CloseHandle(mappingHandle_);
+    }
+    if (fileHandle_)
+    {
+      CloseHandle(fileHandle_);
+    }
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+#else
+    if (data_)
+    {
+      munmap(data_, size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+  }
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <string>
+
+
+namespace blocks
+{
+  enum class MappingAdvice
+  {
+    WillNeed,
+    DontNeed,
+  };
+
+  // Shared read-write mapping of a file, created or extended to the requested size.
+  // Changes reach the file through the page cache, Flush forces them to stable storage.
+  class WritableMappedFile
+  {
+  public:
+    WritableMappedFile(std::string path, size_t size);
+    WritableMappedFile(const WritableMappedFile&) = delete;
+    WritableMappedFile(WritableMappedFile&& other) = delete;
+    WritableMappedFile& operator=(const WritableMappedFile&) = delete;
+    WritableMappedFile& operator=(WritableMappedFile&& other) = delete;
+    ~WritableMappedFile();
+
+    bool IsOpen() const;
+    unsigned char* GetData() const;
+    size_t GetSize() const;
+
+    bool Flush();
+    // Range has to start on a page boundary
+    void Advise(size_t offset, size_t size, MappingAdvice advice);
+
+  private:
+    void Release();
+
+    unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#ifdef _WIN32
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+  };
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+
+namespace blocks
+{
+  // Rounds towards negative infinity, negative cells belong to negative chunks and negative chunks to negative regions
+  inline int floorDivide(int value, int divisor)
+  {
+    return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+  }
+}
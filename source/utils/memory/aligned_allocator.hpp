@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+
+
+namespace blocks
+{
+  static const size_t CacheLineSize = 64;
+
+  // Allocator for flat arrays that are scanned in hot loops or processed with SIMD
+  template <typename T, size_t Alignment = CacheLineSize>
+  struct AlignedAllocator
+  {
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind
+    {
+      typedef AlignedAllocator<U, Alignment> other;
+    };
+
+    AlignedAllocator() noexcept {}
+
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+    T* allocate(size_t n)
+    {
+      return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+    }
+
+    void deallocate(T* pointer, size_t n) noexcept
+    {
+      ::operator delete(pointer, std::align_val_t(Alignment));
+    }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U, Alignment>&) const noexcept
+    {
+      return true;
+    }
+
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U, Alignment>&) const noexcept
+    {
+      return false;
+    }
+  };
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+// Widest instruction set the translation unit is built for, kernels pick their path with
+// BLOCKS_SIMD_AVX2 or BLOCKS_SIMD_SSE and keep a scalar fallback for neither
+#if defined(__AVX2__)
+#define BLOCKS_SIMD_AVX2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCKS_SIMD_SSE
+#include <emmintrin.h>
+#endif